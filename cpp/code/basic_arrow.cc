@@ -16,9 +16,27 @@
 // under the License.
 
 #include <arrow/api.h>
+#include <arrow/compute/api.h>
+#include <arrow/dataset/api.h>
+#include <arrow/util/bit_block_counter.h>
+#include <arrow/util/bit_run_reader.h>
+#include <arrow/util/bit_util.h>
+#include <arrow/util/decimal.h>
+#include <arrow/util/ree_util.h>
+#include <arrow/util/thread_pool.h>
 #include <arrow/visit_array_inline.h>
 #include <gtest/gtest.h>
 
+#include <cmath>
+#include <deque>
+#include <limits>
+#include <optional>
+#include <random>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "basic_arrow.h"
 #include "common.h"
 
 arrow::Status ReturnNotOkMacro() {
@@ -132,3 +150,830 @@ arrow::Status VisitorSummationExample() {
 }
 
 TEST(BasicArrow, VisitorSummationExample) { ASSERT_OK(VisitorSummationExample()); }
+
+/// \brief Sum the valid values of a numeric array, each multiplied by a weight
+///
+/// Used to sum encoded arrays without decoding them, where each weight is the
+/// number of times a value is repeated in the decoded array.
+class WeightedSummation {
+  const std::vector<int64_t>& weights;
+  double partial = 0.0;
+
+ public:
+  explicit WeightedSummation(const std::vector<int64_t>& weights) : weights(weights) {}
+
+  arrow::Result<double> Compute(const arrow::Array& values) {
+    ARROW_RETURN_NOT_OK(arrow::VisitArrayInline(values, this));
+    return partial;
+  }
+
+  arrow::Status Visit(const arrow::Array& array) {
+    return arrow::Status::NotImplemented(
+        "Can not compute sum for encoded values of type ", array.type()->ToString());
+  }
+
+  template <typename ArrayType, typename T = typename ArrayType::TypeClass>
+  arrow::enable_if_number<T, arrow::Status> Visit(const ArrayType& array) {
+    for (int64_t i = 0; i < array.length(); i++) {
+      if (weights[i] != 0 && array.IsValid(i)) {
+        partial += static_cast<double>(weights[i]) * static_cast<double>(array.Value(i));
+      }
+    }
+    return arrow::Status::OK();
+  }
+};  // WeightedSummation
+
+/// \brief Count how many times each dictionary index appears, ignoring nulls
+class IndexCounter {
+  std::vector<int64_t>* counts;
+
+ public:
+  explicit IndexCounter(std::vector<int64_t>* counts) : counts(counts) {}
+
+  arrow::Status Visit(const arrow::Array& array) {
+    return arrow::Status::TypeError("Dictionary indices must be integers, not ",
+                                    array.type()->ToString());
+  }
+
+  template <typename ArrayType, typename T = typename ArrayType::TypeClass>
+  arrow::enable_if_integer<T, arrow::Status> Visit(const ArrayType& array) {
+    const typename T::c_type* indices = array.raw_values();
+    for (int64_t i = 0; i < array.length(); i++) {
+      if (array.null_count() == 0 || array.IsValid(i)) {
+        (*counts)[static_cast<size_t>(indices[i])]++;
+      }
+    }
+    return arrow::Status::OK();
+  }
+};  // IndexCounter
+
+/// \brief Count how many times each value of a run-end encoded array is repeated
+template <typename RunEndCType>
+std::vector<int64_t> RunLengths(const arrow::RunEndEncodedArray& array) {
+  std::vector<int64_t> run_lengths(array.values()->length(), 0);
+  arrow::ArraySpan span(*array.data());
+  arrow::ree_util::RunEndEncodedArraySpan<RunEndCType> ree_span(span);
+  for (typename arrow::ree_util::RunEndEncodedArraySpan<RunEndCType>::Iterator it =
+           ree_span.begin();
+       !it.is_end(ree_span); ++it) {
+    run_lengths[it.index_into_array()] += it.run_length();
+  }
+  return run_lengths;
+}
+
+/// \brief Sum a run of values that are all valid
+///
+/// Several independent accumulators break the chain of dependent additions, which
+/// lets the compiler vectorize the loop.  This deliberately adds the values in a
+/// different order than a plain loop would: integers are summed exactly (as long as
+/// the total fits into a double's 53 bit mantissa) but a sum of floating point
+/// values may differ from a plain loop in the last bits.
+template <typename CType>
+double SumValues(const CType* values, int64_t length) {
+  constexpr int64_t kLanes = 8;
+  double lanes[kLanes] = {};
+  int64_t i = 0;
+  for (; i + kLanes <= length; i += kLanes) {
+    for (int64_t lane = 0; lane < kLanes; lane++) {
+      lanes[lane] += static_cast<double>(values[i + lane]);
+    }
+  }
+  double total = 0.0;
+  for (; i < length; i++) {
+    total += static_cast<double>(values[i]);
+  }
+  for (double lane : lanes) {
+    total += lane;
+  }
+  return total;
+}
+
+/// \brief Sum numeric values across columns, reading the values buffers directly
+///
+/// Gives the same result as TableSummation (up to floating point rounding) but
+/// avoids the per-value branch of the array iterator.  TableSummation is kept as it
+/// is, as the simple version to compare this one with, rather than dispatching to
+/// this class.  The validity bitmap is
+/// examined a block of 256 values at a time so that blocks with no nulls, or only
+/// nulls, are handled without looking at individual bits.
+///
+/// Also supports decimals, lists of numbers, and dictionary and run-end encoded
+/// arrays of numbers.  Encoded arrays are summed without decoding them.
+class FastTableSummation {
+  double partial = 0.0;
+
+ public:
+  arrow::Result<double> Compute(std::shared_ptr<arrow::RecordBatch> batch) {
+    for (std::shared_ptr<arrow::Array> array : batch->columns()) {
+      ARROW_RETURN_NOT_OK(arrow::VisitArrayInline(*array, this));
+    }
+    return partial;
+  }
+
+  arrow::Result<double> Compute(const arrow::Array& array) {
+    ARROW_RETURN_NOT_OK(arrow::VisitArrayInline(array, this));
+    return partial;
+  }
+
+  // Default implementation
+  arrow::Status Visit(const arrow::Array& array) {
+    return arrow::Status::NotImplemented("Can not compute sum for array of type ",
+                                         array.type()->ToString());
+  }
+
+  template <typename ArrayType, typename T = typename ArrayType::TypeClass>
+  arrow::enable_if_number<T, arrow::Status> Visit(const ArrayType& array) {
+    const typename T::c_type* values = array.raw_values();
+    if (array.null_count() == 0) {
+      partial += SumValues(values, array.length());
+      return arrow::Status::OK();
+    }
+
+    const uint8_t* validity = array.null_bitmap_data();
+    arrow::internal::BitBlockCounter counter(validity, array.offset(), array.length());
+    int64_t position = 0;
+    while (position < array.length()) {
+      arrow::internal::BitBlockCount block = counter.NextFourWords();
+      if (block.AllSet()) {
+        partial += SumValues(values + position, block.length);
+      } else if (!block.NoneSet()) {
+        double block_sum = 0.0;
+        for (int64_t i = position; i < position + block.length; i++) {
+          // Null slots can hold any value, so they are masked out without branching
+          bool valid = arrow::bit_util::GetBit(validity, array.offset() + i);
+          block_sum += valid ? static_cast<double>(values[i]) : 0.0;
+        }
+        partial += block_sum;
+      }
+      position += block.length;
+    }
+    return arrow::Status::OK();
+  }
+
+  template <typename ArrayType, typename T = typename ArrayType::TypeClass>
+  arrow::enable_if_t<arrow::is_decimal128_type<T>::value ||
+                         arrow::is_decimal256_type<T>::value,
+                     arrow::Status>
+  Visit(const ArrayType& array) {
+    // Add up the decimals exactly and only convert the total to a double
+    arrow::Decimal256 total;
+    for (int64_t i = 0; i < array.length(); i++) {
+      if (array.IsValid(i)) {
+        typename arrow::TypeTraits<T>::CType value(array.GetValue(i));
+        total += arrow::Decimal256(value);
+      }
+    }
+    const arrow::DecimalType& type =
+        static_cast<const arrow::DecimalType&>(*array.type());
+    partial += total.ToDouble(type.scale());
+    return arrow::Status::OK();
+  }
+
+  template <typename ArrayType, typename T = typename ArrayType::TypeClass>
+  arrow::enable_if_t<std::is_same<T, arrow::ListType>::value ||
+                         std::is_same<T, arrow::LargeListType>::value,
+                     arrow::Status>
+  Visit(const ArrayType& array) {
+    // Without nulls the values of all lists are one contiguous range of the child
+    std::shared_ptr<arrow::Array> values;
+    if (array.null_count() == 0) {
+      int64_t start = array.value_offset(0);
+      values = array.values()->Slice(start, array.value_offset(array.length()) - start);
+    } else {
+      ARROW_ASSIGN_OR_RAISE(values, array.Flatten());
+    }
+    return arrow::VisitArrayInline(*values, this);
+  }
+
+  arrow::Status Visit(const arrow::DictionaryArray& array) {
+    // Sum each dictionary value once, weighted by how often it is used
+    std::vector<int64_t> counts(array.dictionary()->length(), 0);
+    IndexCounter counter(&counts);
+    ARROW_RETURN_NOT_OK(arrow::VisitArrayInline(*array.indices(), &counter));
+    WeightedSummation summation(counts);
+    ARROW_ASSIGN_OR_RAISE(double total, summation.Compute(*array.dictionary()));
+    partial += total;
+    return arrow::Status::OK();
+  }
+
+  arrow::Status Visit(const arrow::RunEndEncodedArray& array) {
+    // Sum each run once, weighted by its length
+    std::vector<int64_t> run_lengths;
+    switch (array.run_ends()->type_id()) {
+      case arrow::Type::INT16:
+        run_lengths = RunLengths<int16_t>(array);
+        break;
+      case arrow::Type::INT32:
+        run_lengths = RunLengths<int32_t>(array);
+        break;
+      default:
+        run_lengths = RunLengths<int64_t>(array);
+        break;
+    }
+    WeightedSummation summation(run_lengths);
+    ARROW_ASSIGN_OR_RAISE(double total, summation.Compute(*array.values()));
+    partial += total;
+    return arrow::Status::OK();
+  }
+};  // FastTableSummation
+
+/// \brief Create a column of random values where roughly `null_probability` of the
+/// values are null
+template <typename ArrowType>
+arrow::Result<std::shared_ptr<arrow::Array>> RandomNumericArray(int64_t length,
+                                                                double null_probability,
+                                                                std::mt19937* gen) {
+  using CType = typename ArrowType::c_type;
+  std::uniform_int_distribution<int32_t> value_dist(-1000, 1000);
+  std::bernoulli_distribution null_dist(null_probability);
+  arrow::NumericBuilder<ArrowType> builder;
+  ARROW_RETURN_NOT_OK(builder.Reserve(length));
+  for (int64_t i = 0; i < length; i++) {
+    if (null_dist(*gen)) {
+      builder.UnsafeAppendNull();
+    } else {
+      builder.UnsafeAppend(static_cast<CType>(value_dist(*gen)));
+    }
+  }
+  return builder.Finish();
+}
+
+template arrow::Result<std::shared_ptr<arrow::Array>>
+RandomNumericArray<arrow::Int32Type>(int64_t, double, std::mt19937*);
+template arrow::Result<std::shared_ptr<arrow::Array>>
+RandomNumericArray<arrow::Int64Type>(int64_t, double, std::mt19937*);
+template arrow::Result<std::shared_ptr<arrow::Array>>
+RandomNumericArray<arrow::DoubleType>(int64_t, double, std::mt19937*);
+
+arrow::Result<double> SumWithIterator(const std::shared_ptr<arrow::RecordBatch>& batch) {
+  TableSummation summation;
+  return summation.Compute(batch);
+}
+
+arrow::Result<double> SumWithBuffers(const std::shared_ptr<arrow::RecordBatch>& batch) {
+  FastTableSummation summation;
+  return summation.Compute(batch);
+}
+
+arrow::Status CompareSummationVisitors() {
+  constexpr int64_t kLength = 1000;
+  std::mt19937 gen(42);
+  std::vector<std::shared_ptr<arrow::Array>> arrays;
+  std::vector<double> null_probabilities = {0.0, 0.01, 0.5};
+  for (double null_probability : null_probabilities) {
+    ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Array> int32_array,
+                          RandomNumericArray<arrow::Int32Type>(kLength, null_probability,
+                                                               &gen));
+    ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Array> double_array,
+                          RandomNumericArray<arrow::DoubleType>(kLength, null_probability,
+                                                                &gen));
+    arrays.push_back(int32_array);
+    arrays.push_back(double_array);
+  }
+
+  StartRecipe("ComparingSummationVisitors");
+  for (const std::shared_ptr<arrow::Array>& array : arrays) {
+    std::shared_ptr<arrow::RecordBatch> batch = arrow::RecordBatch::Make(
+        arrow::schema({arrow::field("x", array->type())}), array->length(), {array});
+    ARROW_ASSIGN_OR_RAISE(double iterator_total, SumWithIterator(batch));
+    ARROW_ASSIGN_OR_RAISE(double fast_total, SumWithBuffers(batch));
+    rout << array->type()->ToString() << " with " << array->null_count()
+         << " nulls: iterator sum " << iterator_total << ", fast sum " << fast_total
+         << std::endl;
+    // Every value is a small integer so there is no rounding error to worry about
+    EXPECT_EQ(iterator_total, fast_total);
+  }
+  EndRecipe("ComparingSummationVisitors");
+  return arrow::Status::OK();
+}
+
+TEST(BasicArrow, CompareSummationVisitors) { ASSERT_OK(CompareSummationVisitors()); }
+
+/// \brief A running sum that also tracks the rounding error of each addition
+///
+/// This is Neumaier's variant of Kahan summation.  The total is far more accurate
+/// than adding the values one after the other, and so depends much less on the
+/// magnitude of the values added.
+class CompensatedSum {
+  double sum = 0.0;
+  double compensation = 0.0;
+
+ public:
+  void Add(double value) {
+    double next = sum + value;
+    if (std::abs(sum) >= std::abs(value)) {
+      compensation += (sum - next) + value;
+    } else {
+      compensation += (value - next) + sum;
+    }
+    sum = next;
+  }
+
+  double Total() const { return sum + compensation; }
+};
+
+/// \brief Sum numeric values across columns using many threads
+///
+/// Every column of every batch is summed as a separate task on `executor`.  Batches
+/// are read from the reader only as fast as they can be summed, so the input does
+/// not need to fit in memory.  The partial sums are combined in the order the
+/// batches were read, not the order the tasks finish, which makes the result
+/// independent of the number of threads.
+///
+/// Compute blocks the calling thread until the tasks are done, so it must not be
+/// called from a thread of `executor`: with every thread waiting, no thread would be
+/// left to run the tasks.
+class ParallelTableSummation {
+  arrow::internal::Executor* executor;
+
+ public:
+  explicit ParallelTableSummation(
+      arrow::internal::Executor* executor = arrow::internal::GetCpuThreadPool())
+      : executor(executor) {}
+
+  arrow::Result<double> Compute(arrow::RecordBatchReader* reader) {
+    if (executor->OwnsThisThread()) {
+      return arrow::Status::Invalid(
+          "ParallelTableSummation can't wait for its tasks on one of their threads");
+    }
+    // Allow a few batches per thread to be in flight, enough to keep every thread busy
+    const size_t max_batches_in_flight = 2 * executor->GetCapacity();
+    std::deque<std::vector<arrow::Future<double>>> in_flight;
+    CompensatedSum total;
+    while (true) {
+      ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::RecordBatch> batch,
+                            reader->Next());
+      if (batch != nullptr) {
+        std::vector<arrow::Future<double>> column_sums;
+        for (const std::shared_ptr<arrow::Array>& column : batch->columns()) {
+          ARROW_ASSIGN_OR_RAISE(arrow::Future<double> column_sum,
+                                executor->Submit([column]() -> arrow::Result<double> {
+                                  FastTableSummation summation;
+                                  return summation.Compute(*column);
+                                }));
+          column_sums.push_back(std::move(column_sum));
+        }
+        in_flight.push_back(std::move(column_sums));
+      }
+      // Wait for the oldest batch once enough are in flight or there are no more
+      while (!in_flight.empty() &&
+             (batch == nullptr || in_flight.size() >= max_batches_in_flight)) {
+        for (const arrow::Future<double>& column_sum : in_flight.front()) {
+          ARROW_ASSIGN_OR_RAISE(double partial, column_sum.result());
+          total.Add(partial);
+        }
+        in_flight.pop_front();
+      }
+      if (batch == nullptr) break;
+    }
+    return total.Total();
+  }
+
+  arrow::Result<double> Compute(const arrow::Table& table) {
+    // Yields one batch per chunk, or slices of chunks where columns are chunked
+    // differently
+    arrow::TableBatchReader reader(table);
+    return Compute(&reader);
+  }
+
+  arrow::Result<double> Compute(arrow::dataset::Scanner* scanner) {
+    // The scanner reads and decodes batches on its own threads, in order
+    ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::RecordBatchReader> reader,
+                          scanner->ToRecordBatchReader());
+    return Compute(reader.get());
+  }
+};  // ParallelTableSummation
+
+arrow::Result<double> SumInParallel(const arrow::Table& table,
+                                    arrow::internal::Executor* executor) {
+  ParallelTableSummation summation(executor);
+  return summation.Compute(table);
+}
+
+arrow::Result<std::shared_ptr<arrow::Table>> RandomLognormalTable(int num_chunks,
+                                                                  int64_t chunk_length) {
+  std::mt19937 gen(42);
+  // Values of very different magnitudes make the order of additions matter
+  std::lognormal_distribution<double> value_dist(0.0, 8.0);
+  std::shared_ptr<arrow::Schema> schema = arrow::schema({
+      arrow::field("a", arrow::float64()),
+      arrow::field("b", arrow::float64()),
+  });
+  std::vector<std::shared_ptr<arrow::RecordBatch>> batches;
+  for (int chunk = 0; chunk < num_chunks; chunk++) {
+    std::vector<std::shared_ptr<arrow::Array>> columns;
+    for (int column = 0; column < schema->num_fields(); column++) {
+      arrow::DoubleBuilder builder;
+      ARROW_RETURN_NOT_OK(builder.Reserve(chunk_length));
+      for (int64_t i = 0; i < chunk_length; i++) {
+        builder.UnsafeAppend(value_dist(gen));
+      }
+      ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Array> array, builder.Finish());
+      columns.push_back(array);
+    }
+    batches.push_back(arrow::RecordBatch::Make(schema, chunk_length, columns));
+  }
+  return arrow::Table::FromRecordBatches(schema, batches);
+}
+
+arrow::Status ParallelSummationExample() {
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Table> table,
+                        RandomLognormalTable(/*num_chunks=*/16, /*chunk_length=*/4096));
+
+  StartRecipe("ParallelSummationExample");
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::internal::ThreadPool> one_thread,
+                        arrow::internal::ThreadPool::Make(1));
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::internal::ThreadPool> eight_threads,
+                        arrow::internal::ThreadPool::Make(8));
+  ParallelTableSummation serial_summation(one_thread.get());
+  ARROW_ASSIGN_OR_RAISE(double serial_total, serial_summation.Compute(*table));
+  ParallelTableSummation parallel_summation(eight_threads.get());
+  ARROW_ASSIGN_OR_RAISE(double parallel_total, parallel_summation.Compute(*table));
+
+  // A dataset is summed through a scanner, here of a dataset held in memory
+  std::shared_ptr<arrow::dataset::Dataset> dataset =
+      std::make_shared<arrow::dataset::InMemoryDataset>(table);
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::dataset::ScannerBuilder> scanner_builder,
+                        dataset->NewScan());
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::dataset::Scanner> scanner,
+                        scanner_builder->Finish());
+  ParallelTableSummation dataset_summation;
+  ARROW_ASSIGN_OR_RAISE(double dataset_total, dataset_summation.Compute(scanner.get()));
+
+  rout << "Total with 1 thread is " << serial_total << std::endl;
+  rout << "Identical with 8 threads: " << (serial_total == parallel_total ? "yes" : "no")
+       << std::endl;
+  rout << "Identical from a dataset: " << (serial_total == dataset_total ? "yes" : "no")
+       << std::endl;
+  EndRecipe("ParallelSummationExample");
+
+  EXPECT_EQ(serial_total, parallel_total);
+  EXPECT_EQ(serial_total, dataset_total);
+
+  // Waiting on the pool from one of its own threads is refused instead of deadlocking
+  ARROW_ASSIGN_OR_RAISE(arrow::Future<double> nested,
+                        one_thread->Submit([&]() -> arrow::Result<double> {
+                          return serial_summation.Compute(*table);
+                        }));
+  EXPECT_TRUE(nested.result().status().IsInvalid());
+  return arrow::Status::OK();
+}
+
+TEST(BasicArrow, ParallelSummationExample) { ASSERT_OK(ParallelSummationExample()); }
+
+arrow::Result<double> SumWithBuffers(const arrow::Array& array) {
+  FastTableSummation summation;
+  return summation.Compute(array);
+}
+
+arrow::Result<std::shared_ptr<arrow::Array>> LongRunsArray(int64_t length,
+                                                           int64_t num_runs) {
+  arrow::Int64Builder run_ends_builder;
+  arrow::Int64Builder run_values_builder;
+  for (int64_t run = 1; run <= num_runs; run++) {
+    ARROW_RETURN_NOT_OK(run_ends_builder.Append(run * length / num_runs));
+    ARROW_RETURN_NOT_OK(run_values_builder.Append(run));
+  }
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Array> run_ends,
+                        run_ends_builder.Finish());
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Array> run_values,
+                        run_values_builder.Finish());
+  return arrow::RunEndEncodedArray::Make(length, run_ends, run_values);
+}
+
+arrow::Status EncodedSummationExample() {
+  StartRecipe("EncodedSummationExample");
+  std::vector<std::shared_ptr<arrow::Array>> columns;
+
+  // The values 10, 20, 10, 30, 10 stored as indices into a dictionary
+  arrow::Int32Builder dictionary_builder;
+  ARROW_RETURN_NOT_OK(dictionary_builder.AppendValues({10, 20, 30}));
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Array> dictionary,
+                        dictionary_builder.Finish());
+  arrow::Int8Builder indices_builder;
+  ARROW_RETURN_NOT_OK(indices_builder.AppendValues({0, 1, 0, 2, 0}));
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Array> indices, indices_builder.Finish());
+  ARROW_ASSIGN_OR_RAISE(
+      std::shared_ptr<arrow::Array> dictionary_array,
+      arrow::DictionaryArray::FromArrays(arrow::dictionary(arrow::int8(), arrow::int32()),
+                                         indices, dictionary));
+  columns.push_back(dictionary_array);
+
+  // The values 1.5 (twice), 2.5 (once) and 4 (twice) stored as runs
+  arrow::Int32Builder run_ends_builder;
+  ARROW_RETURN_NOT_OK(run_ends_builder.AppendValues({2, 3, 5}));
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Array> run_ends,
+                        run_ends_builder.Finish());
+  arrow::DoubleBuilder run_values_builder;
+  ARROW_RETURN_NOT_OK(run_values_builder.AppendValues({1.5, 2.5, 4.0}));
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Array> run_values,
+                        run_values_builder.Finish());
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Array> ree_array,
+                        arrow::RunEndEncodedArray::Make(5, run_ends, run_values));
+  columns.push_back(ree_array);
+
+  arrow::Decimal128Builder decimal_builder(arrow::decimal128(10, 2));
+  for (const char* value : {"0.10", "0.20", "0.30", "1.00", "-0.60"}) {
+    ARROW_ASSIGN_OR_RAISE(arrow::Decimal128 decimal,
+                          arrow::Decimal128::FromString(value));
+    ARROW_RETURN_NOT_OK(decimal_builder.Append(decimal));
+  }
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Array> decimal_array,
+                        decimal_builder.Finish());
+  columns.push_back(decimal_array);
+
+  // [[1, 2], [], null, [3], [4, 5, 6]]
+  arrow::ListBuilder list_builder(arrow::default_memory_pool(),
+                                  std::make_shared<arrow::Int64Builder>());
+  arrow::Int64Builder* item_builder =
+      static_cast<arrow::Int64Builder*>(list_builder.value_builder());
+  ARROW_RETURN_NOT_OK(list_builder.Append());
+  ARROW_RETURN_NOT_OK(item_builder->AppendValues({1, 2}));
+  ARROW_RETURN_NOT_OK(list_builder.Append());
+  ARROW_RETURN_NOT_OK(list_builder.AppendNull());
+  ARROW_RETURN_NOT_OK(list_builder.Append());
+  ARROW_RETURN_NOT_OK(item_builder->Append(3));
+  ARROW_RETURN_NOT_OK(list_builder.Append());
+  ARROW_RETURN_NOT_OK(item_builder->AppendValues({4, 5, 6}));
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Array> list_array, list_builder.Finish());
+  columns.push_back(list_array);
+
+  for (const std::shared_ptr<arrow::Array>& column : columns) {
+    FastTableSummation summation;
+    ARROW_ASSIGN_OR_RAISE(double total, summation.Compute(*column));
+    rout << column->type()->ToString() << " sums to " << total << std::endl;
+  }
+  EndRecipe("EncodedSummationExample");
+
+  std::vector<double> expected = {80.0, 13.5, 1.0, 21.0};
+  for (size_t i = 0; i < columns.size(); i++) {
+    FastTableSummation summation;
+    ARROW_ASSIGN_OR_RAISE(double total, summation.Compute(*columns[i]));
+    EXPECT_DOUBLE_EQ(total, expected[i]);
+  }
+
+  // Long runs are summed in time proportional to the number of runs, not the length
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Array> long_ree_array,
+                        LongRunsArray(/*length=*/1 << 12, /*num_runs=*/16));
+  ARROW_ASSIGN_OR_RAISE(arrow::Datum decoded,
+                        arrow::compute::RunEndDecode(long_ree_array));
+  ARROW_ASSIGN_OR_RAISE(double encoded_total, SumWithBuffers(*long_ree_array));
+  ARROW_ASSIGN_OR_RAISE(double decoded_total, SumWithBuffers(*decoded.make_array()));
+  EXPECT_EQ(encoded_total, decoded_total);
+  return arrow::Status::OK();
+}
+
+TEST(BasicArrow, EncodedSummationExample) { ASSERT_OK(EncodedSummationExample()); }
+
+/// \brief Aggregates that can be computed together by FusedAggregation
+///
+/// Each aggregate has a name, an output type, an Update method that is called
+/// with every valid value and a Value method that returns the result, or nothing
+/// if there were no valid values.
+struct SumAggregate {
+  static constexpr const char* kName = "sum";
+  using OutputType = arrow::DoubleType;
+  double sum = 0.0;
+  void Update(double value) { sum += value; }
+  std::optional<double> Value() const { return sum; }
+};
+
+struct MinAggregate {
+  static constexpr const char* kName = "min";
+  using OutputType = arrow::DoubleType;
+  double min = std::numeric_limits<double>::infinity();
+  bool seen = false;
+  void Update(double value) {
+    min = std::min(min, value);
+    seen = true;
+  }
+  std::optional<double> Value() const {
+    return seen ? std::optional<double>(min) : std::nullopt;
+  }
+};
+
+struct MaxAggregate {
+  static constexpr const char* kName = "max";
+  using OutputType = arrow::DoubleType;
+  double max = -std::numeric_limits<double>::infinity();
+  bool seen = false;
+  void Update(double value) {
+    max = std::max(max, value);
+    seen = true;
+  }
+  std::optional<double> Value() const {
+    return seen ? std::optional<double>(max) : std::nullopt;
+  }
+};
+
+struct CountAggregate {
+  static constexpr const char* kName = "count";
+  using OutputType = arrow::Int64Type;
+  int64_t count = 0;
+  void Update(double) { count++; }
+  std::optional<int64_t> Value() const { return count; }
+};
+
+struct MeanAggregate {
+  static constexpr const char* kName = "mean";
+  using OutputType = arrow::DoubleType;
+  double sum = 0.0;
+  int64_t count = 0;
+  void Update(double value) {
+    sum += value;
+    count++;
+  }
+  std::optional<double> Value() const {
+    return count > 0 ? std::optional<double>(sum / count) : std::nullopt;
+  }
+};
+
+/// \brief Compute several aggregates of every numeric column in a single pass
+///
+/// The aggregates are template parameters, so the loop over the values of a column
+/// calls every aggregate's Update directly and the compiler can inline them all.
+/// The result has one row per column.
+template <typename... Aggregates>
+class FusedAggregation {
+  std::tuple<Aggregates...> current;
+
+ public:
+  arrow::Result<std::shared_ptr<arrow::RecordBatch>> Compute(
+      const arrow::RecordBatch& batch) {
+    arrow::StringBuilder column_builder;
+    std::tuple<arrow::NumericBuilder<typename Aggregates::OutputType>...> builders;
+    for (int i = 0; i < batch.num_columns(); i++) {
+      current = std::tuple<Aggregates...>();
+      ARROW_RETURN_NOT_OK(arrow::VisitArrayInline(*batch.column(i), this));
+      ARROW_RETURN_NOT_OK(column_builder.Append(batch.schema()->field(i)->name()));
+      ARROW_RETURN_NOT_OK(
+          AppendResults(&builders, std::index_sequence_for<Aggregates...>()));
+    }
+
+    std::vector<std::shared_ptr<arrow::Array>> columns(1 + sizeof...(Aggregates));
+    ARROW_RETURN_NOT_OK(column_builder.Finish(&columns[0]));
+    ARROW_RETURN_NOT_OK(
+        FinishResults(&builders, &columns, std::index_sequence_for<Aggregates...>()));
+    std::shared_ptr<arrow::Schema> schema = arrow::schema(
+        {arrow::field("column", arrow::utf8()),
+         arrow::field(Aggregates::kName,
+                      std::make_shared<typename Aggregates::OutputType>())...});
+    return arrow::RecordBatch::Make(schema, batch.num_columns(), std::move(columns));
+  }
+
+  // Default implementation
+  arrow::Status Visit(const arrow::Array& array) {
+    return arrow::Status::NotImplemented("Can not aggregate array of type ",
+                                         array.type()->ToString());
+  }
+
+  template <typename ArrayType, typename T = typename ArrayType::TypeClass>
+  arrow::enable_if_number<T, arrow::Status> Visit(const ArrayType& array) {
+    const typename T::c_type* values = array.raw_values();
+    std::tuple<Aggregates...> state = current;
+    arrow::internal::VisitSetBitRunsVoid(
+        array.null_bitmap_data(), array.offset(), array.length(),
+        [&](int64_t position, int64_t length) {
+          for (int64_t i = position; i < position + length; i++) {
+            double value = static_cast<double>(values[i]);
+            std::apply(
+                [value](Aggregates&... aggregates) { (aggregates.Update(value), ...); },
+                state);
+          }
+        });
+    current = state;
+    return arrow::Status::OK();
+  }
+
+ private:
+  template <typename Builders, size_t... I>
+  arrow::Status AppendResults(Builders* builders, std::index_sequence<I...>) {
+    arrow::Status status;
+    ((status &= AppendResult(&std::get<I>(*builders), std::get<I>(current).Value())),
+     ...);
+    return status;
+  }
+
+  template <typename Builder, typename CType>
+  static arrow::Status AppendResult(Builder* builder, std::optional<CType> value) {
+    return value.has_value() ? builder->Append(*value) : builder->AppendNull();
+  }
+
+  template <typename Builders, size_t... I>
+  static arrow::Status FinishResults(Builders* builders,
+                                     std::vector<std::shared_ptr<arrow::Array>>* columns,
+                                     std::index_sequence<I...>) {
+    arrow::Status status;
+    ((status &= std::get<I>(*builders).Finish(&(*columns)[I + 1])), ...);
+    return status;
+  }
+};  // FusedAggregation
+
+arrow::Status FusedAggregationExample() {
+  StartRecipe("FusedAggregationExample");
+  std::shared_ptr<arrow::Schema> schema = arrow::schema({
+      arrow::field("a", arrow::int32()),
+      arrow::field("b", arrow::float64()),
+  });
+  arrow::Int32Builder a_builder;
+  ARROW_RETURN_NOT_OK(a_builder.AppendValues({1, 2, 3}));
+  ARROW_RETURN_NOT_OK(a_builder.AppendNull());
+  std::shared_ptr<arrow::Array> a_arr;
+  ARROW_RETURN_NOT_OK(a_builder.Finish(&a_arr));
+  arrow::DoubleBuilder b_builder;
+  ARROW_RETURN_NOT_OK(b_builder.AppendValues({4.0, 5.0, 6.0, 7.0}));
+  std::shared_ptr<arrow::Array> b_arr;
+  ARROW_RETURN_NOT_OK(b_builder.Finish(&b_arr));
+  std::shared_ptr<arrow::RecordBatch> batch =
+      arrow::RecordBatch::Make(schema, 4, {a_arr, b_arr});
+
+  FusedAggregation<SumAggregate, MinAggregate, MaxAggregate, CountAggregate,
+                   MeanAggregate>
+      aggregation;
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::RecordBatch> result,
+                        aggregation.Compute(*batch));
+  rout << result->ToString();
+  EndRecipe("FusedAggregationExample");
+
+  EXPECT_EQ(result->num_rows(), 2);
+  EXPECT_EQ(result->num_columns(), 6);
+  return arrow::Status::OK();
+}
+
+arrow::Result<std::shared_ptr<arrow::RecordBatch>> SummarizeInOnePass(
+    const arrow::RecordBatch& batch) {
+  FusedAggregation<SumAggregate, MinAggregate, MaxAggregate, CountAggregate,
+                   MeanAggregate>
+      aggregation;
+  return aggregation.Compute(batch);
+}
+
+arrow::Result<std::shared_ptr<arrow::RecordBatch>> SummarizeInSeparatePasses(
+    const arrow::RecordBatch& batch) {
+  FusedAggregation<SumAggregate> sum;
+  FusedAggregation<MinAggregate> min;
+  FusedAggregation<MaxAggregate> max;
+  FusedAggregation<CountAggregate> count;
+  FusedAggregation<MeanAggregate> mean;
+  std::vector<std::shared_ptr<arrow::RecordBatch>> passes(5);
+  ARROW_ASSIGN_OR_RAISE(passes[0], sum.Compute(batch));
+  ARROW_ASSIGN_OR_RAISE(passes[1], min.Compute(batch));
+  ARROW_ASSIGN_OR_RAISE(passes[2], max.Compute(batch));
+  ARROW_ASSIGN_OR_RAISE(passes[3], count.Compute(batch));
+  ARROW_ASSIGN_OR_RAISE(passes[4], mean.Compute(batch));
+
+  // Every pass has the column names first, followed by its one aggregate
+  std::vector<std::shared_ptr<arrow::Field>> fields = {passes[0]->schema()->field(0)};
+  std::vector<std::shared_ptr<arrow::Array>> columns = {passes[0]->column(0)};
+  for (const std::shared_ptr<arrow::RecordBatch>& pass : passes) {
+    fields.push_back(pass->schema()->field(1));
+    columns.push_back(pass->column(1));
+  }
+  return arrow::RecordBatch::Make(arrow::schema(std::move(fields)),
+                                  passes[0]->num_rows(), std::move(columns));
+}
+
+/// \brief Check that one fused pass agrees with separate passes and arrow::compute
+arrow::Status CompareFusedAggregation() {
+  constexpr int64_t kLength = 1 << 12;
+  std::mt19937 gen(42);
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Array> array,
+                        RandomNumericArray<arrow::DoubleType>(kLength, 0.01, &gen));
+  std::shared_ptr<arrow::RecordBatch> batch = arrow::RecordBatch::Make(
+      arrow::schema({arrow::field("x", arrow::float64())}), kLength, {array});
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::RecordBatch> fused_result,
+                        SummarizeInOnePass(*batch));
+  ARROW_ASSIGN_OR_RAISE(arrow::Datum compute_sum, arrow::compute::Sum(array));
+  ARROW_ASSIGN_OR_RAISE(arrow::Datum compute_min_max, arrow::compute::MinMax(array));
+  const arrow::StructScalar& min_max =
+      compute_min_max.scalar_as<arrow::StructScalar>();
+
+  std::shared_ptr<arrow::DoubleArray> sums =
+      std::static_pointer_cast<arrow::DoubleArray>(fused_result->column(1));
+  std::shared_ptr<arrow::DoubleArray> mins =
+      std::static_pointer_cast<arrow::DoubleArray>(fused_result->column(2));
+  std::shared_ptr<arrow::DoubleArray> maxes =
+      std::static_pointer_cast<arrow::DoubleArray>(fused_result->column(3));
+  std::shared_ptr<arrow::Int64Array> counts =
+      std::static_pointer_cast<arrow::Int64Array>(fused_result->column(4));
+  EXPECT_NEAR(sums->Value(0), compute_sum.scalar_as<arrow::DoubleScalar>().value, 1e-6);
+  EXPECT_EQ(mins->Value(0),
+            static_cast<const arrow::DoubleScalar&>(*min_max.value[0]).value);
+  EXPECT_EQ(maxes->Value(0),
+            static_cast<const arrow::DoubleScalar&>(*min_max.value[1]).value);
+  EXPECT_EQ(counts->Value(0), kLength - array->null_count());
+
+  // Each aggregate sees the values in the same order either way, so even the
+  // floating point results match exactly
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::RecordBatch> separate_result,
+                        SummarizeInSeparatePasses(*batch));
+  EXPECT_TRUE(fused_result->Equals(*separate_result))
+      << "Fused:\n"
+      << fused_result->ToString() << "Separate:\n"
+      << separate_result->ToString();
+  return arrow::Status::OK();
+}
+
+TEST(BasicArrow, FusedAggregationExample) { ASSERT_OK(FusedAggregationExample()); }
+
+TEST(BasicArrow, CompareFusedAggregation) { ASSERT_OK(CompareFusedAggregation()); }
@@ -0,0 +1,74 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef ARROW_COOKBOOK_BASIC_ARROW_H
+#define ARROW_COOKBOOK_BASIC_ARROW_H
+
+// Code from basic_arrow.cc that basic_arrow_benchmark.cc measures
+
+#include <arrow/api.h>
+#include <arrow/util/thread_pool.h>
+
+#include <cstdint>
+#include <memory>
+#include <random>
+
+/// \brief Create a column of random values where roughly `null_probability` of the
+/// values are null
+///
+/// Defined for Int32Type, Int64Type and DoubleType.
+template <typename ArrowType>
+arrow::Result<std::shared_ptr<arrow::Array>> RandomNumericArray(int64_t length,
+                                                                double null_probability,
+                                                                std::mt19937* gen);
+
+/// \brief Sum the numeric columns of `batch` with TableSummation, which uses the array
+/// iterator
+arrow::Result<double> SumWithIterator(const std::shared_ptr<arrow::RecordBatch>& batch);
+
+/// \brief Sum the numeric columns of `batch` with FastTableSummation, which reads the
+/// values buffers directly
+arrow::Result<double> SumWithBuffers(const std::shared_ptr<arrow::RecordBatch>& batch);
+
+/// \brief Sum a numeric, decimal, list, dictionary or run-end encoded array with
+/// FastTableSummation
+arrow::Result<double> SumWithBuffers(const arrow::Array& array);
+
+/// \brief A run-end encoded int64 array of `length` values in `num_runs` runs of
+/// equal length
+arrow::Result<std::shared_ptr<arrow::Array>> LongRunsArray(int64_t length,
+                                                           int64_t num_runs);
+
+/// \brief A table of two columns of random doubles of very different magnitudes
+arrow::Result<std::shared_ptr<arrow::Table>> RandomLognormalTable(int num_chunks,
+                                                                  int64_t chunk_length);
+
+/// \brief Sum the numeric columns of `table` with ParallelTableSummation
+arrow::Result<double> SumInParallel(const arrow::Table& table,
+                                    arrow::internal::Executor* executor);
+
+/// \brief Compute the sum, min, max, count and mean of every column of `batch` in a
+/// single pass with FusedAggregation
+arrow::Result<std::shared_ptr<arrow::RecordBatch>> SummarizeInOnePass(
+    const arrow::RecordBatch& batch);
+
+/// \brief Compute the same aggregates as SummarizeInOnePass, with one pass per
+/// aggregate
+arrow::Result<std::shared_ptr<arrow::RecordBatch>> SummarizeInSeparatePasses(
+    const arrow::RecordBatch& batch);
+
+#endif  // ARROW_COOKBOOK_BASIC_ARROW_H
@@ -0,0 +1,172 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <benchmark/benchmark.h>
+
+#include <arrow/api.h>
+#include <arrow/compute/api.h>
+#include <arrow/util/thread_pool.h>
+
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+
+#include "basic_arrow.h"
+#include "benchmark_common.h"
+
+// Benchmarks for the recipes in basic_arrow.cc
+
+namespace {
+
+constexpr int64_t kSummationLength = 1 << 20;
+
+/// \brief A single column batch of random values, with `null_percent` percent nulls
+template <typename ArrowType>
+arrow::Result<std::shared_ptr<arrow::RecordBatch>> RandomBatch(int64_t null_percent) {
+  std::mt19937 gen(42);
+  ARROW_ASSIGN_OR_RAISE(
+      std::shared_ptr<arrow::Array> array,
+      RandomNumericArray<ArrowType>(kSummationLength, null_percent / 100.0, &gen));
+  return arrow::RecordBatch::Make(arrow::schema({arrow::field("x", array->type())}),
+                                  array->length(), {array});
+}
+
+/// \brief Sum a column with TableSummation, FastTableSummation or
+/// arrow::compute::Sum
+template <typename ArrowType>
+arrow::Status SumColumn(benchmark::State& state, const std::string& method) {
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::RecordBatch> batch,
+                        RandomBatch<ArrowType>(state.range(0)));
+  for (auto _ : state) {
+    double total = 0;
+    if (method == "iterator") {
+      ARROW_ASSIGN_OR_RAISE(total, SumWithIterator(batch));
+    } else if (method == "buffers") {
+      ARROW_ASSIGN_OR_RAISE(total, SumWithBuffers(batch));
+    } else {
+      ARROW_ASSIGN_OR_RAISE(arrow::Datum sum, arrow::compute::Sum(batch->column(0)));
+      benchmark::DoNotOptimize(sum);
+    }
+    benchmark::DoNotOptimize(total);
+  }
+  state.SetItemsProcessed(state.iterations() * batch->num_rows());
+  return arrow::Status::OK();
+}
+
+template <typename ArrowType>
+void RegisterSumColumn(const std::string& type_name) {
+  for (const std::string method : {"iterator", "buffers", "compute"}) {
+    RegisterArrowBenchmark("SumColumn<" + type_name + ">/" + method,
+                           SumColumn<ArrowType>, method)
+        ->Unit(benchmark::kMicrosecond)
+        ->ArgName("null_percent")
+        ->Arg(0)
+        ->Arg(1)
+        ->Arg(50);
+  }
+}
+
+/// \brief Sum a table of 2 columns of 4Mi doubles on a pool of `state.range(0)`
+/// threads
+arrow::Status SumTableInParallel(benchmark::State& state) {
+  ARROW_ASSIGN_OR_RAISE(
+      std::shared_ptr<arrow::Table> table,
+      RandomLognormalTable(/*num_chunks=*/64, /*chunk_length=*/1 << 16));
+  ARROW_ASSIGN_OR_RAISE(
+      std::shared_ptr<arrow::internal::ThreadPool> pool,
+      arrow::internal::ThreadPool::Make(static_cast<int>(state.range(0))));
+  for (auto _ : state) {
+    ARROW_ASSIGN_OR_RAISE(double total, SumInParallel(*table, pool.get()));
+    benchmark::DoNotOptimize(total);
+  }
+  state.SetItemsProcessed(state.iterations() * table->num_rows() *
+                          table->num_columns());
+  return arrow::Status::OK();
+}
+
+/// \brief Sum an array of 16Mi values in 16 runs, run-end encoded or decoded
+arrow::Status SumLongRuns(benchmark::State& state, bool decode) {
+  constexpr int64_t kLength = 1 << 24;
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Array> array,
+                        LongRunsArray(kLength, /*num_runs=*/16));
+  if (decode) {
+    ARROW_ASSIGN_OR_RAISE(arrow::Datum decoded, arrow::compute::RunEndDecode(array));
+    array = decoded.make_array();
+  }
+  for (auto _ : state) {
+    ARROW_ASSIGN_OR_RAISE(double total, SumWithBuffers(*array));
+    benchmark::DoNotOptimize(total);
+  }
+  state.SetItemsProcessed(state.iterations() * kLength);
+  return arrow::Status::OK();
+}
+
+/// \brief Compute five aggregates of 8Mi doubles, which do not fit in the CPU caches,
+/// in one pass, in one pass per aggregate, or with arrow::compute
+arrow::Status Summarize(benchmark::State& state, const std::string& method) {
+  constexpr int64_t kLength = 1 << 23;
+  std::mt19937 gen(42);
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Array> array,
+                        RandomNumericArray<arrow::DoubleType>(kLength, 0.01, &gen));
+  std::shared_ptr<arrow::RecordBatch> batch = arrow::RecordBatch::Make(
+      arrow::schema({arrow::field("x", arrow::float64())}), kLength, {array});
+  for (auto _ : state) {
+    if (method == "fused") {
+      ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::RecordBatch> result,
+                            SummarizeInOnePass(*batch));
+      benchmark::DoNotOptimize(result);
+    } else if (method == "separate") {
+      ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::RecordBatch> result,
+                            SummarizeInSeparatePasses(*batch));
+      benchmark::DoNotOptimize(result);
+    } else {
+      ARROW_RETURN_NOT_OK(arrow::compute::Sum(array).status());
+      ARROW_RETURN_NOT_OK(arrow::compute::MinMax(array).status());
+      ARROW_RETURN_NOT_OK(arrow::compute::Count(array).status());
+      ARROW_RETURN_NOT_OK(arrow::compute::Mean(array).status());
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * kLength);
+  return arrow::Status::OK();
+}
+
+int RegisterSummationBenchmarks() {
+  RegisterSumColumn<arrow::Int32Type>("int32");
+  RegisterSumColumn<arrow::Int64Type>("int64");
+  RegisterSumColumn<arrow::DoubleType>("double");
+  RegisterArrowBenchmark("SumTableInParallel", SumTableInParallel)
+      ->Unit(benchmark::kMillisecond)
+      ->UseRealTime()
+      ->ArgName("threads")
+      ->RangeMultiplier(2)
+      ->Range(1, 8);
+  RegisterArrowBenchmark("SumLongRuns/encoded", SumLongRuns, false)
+      ->Unit(benchmark::kMicrosecond);
+  RegisterArrowBenchmark("SumLongRuns/decoded", SumLongRuns, true)
+      ->Unit(benchmark::kMicrosecond);
+  for (const std::string method : {"fused", "separate", "compute"}) {
+    RegisterArrowBenchmark("Summarize/" + method, Summarize, method)
+        ->Unit(benchmark::kMillisecond);
+  }
+  return 0;
+}
+
+[[maybe_unused]] const int kSummationBenchmarksRegistered =
+    RegisterSummationBenchmarks();
+
+}  // namespace
@@ -0,0 +1,43 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef ARROW_COOKBOOK_BENCHMARK_COMMON_H
+#define ARROW_COOKBOOK_BENCHMARK_COMMON_H
+
+#include <arrow/status.h>
+#include <benchmark/benchmark.h>
+
+#include <string>
+
+/// \brief Register a benchmark written as a function that returns arrow::Status
+///
+/// `args` are passed to `function` after the benchmark state.  If the function
+/// returns an error the benchmark is skipped and the error is reported instead.
+template <typename... Params, typename... Args>
+benchmark::internal::Benchmark* RegisterArrowBenchmark(
+    const std::string& name, arrow::Status (*function)(benchmark::State&, Params...),
+    Args... args) {
+  return benchmark::RegisterBenchmark(
+      name.c_str(), [function, args...](benchmark::State& state) {
+        arrow::Status status = function(state, args...);
+        if (!status.ok()) {
+          state.SkipWithError(status.ToString().c_str());
+        }
+      });
+}
+
+#endif  // ARROW_COOKBOOK_BENCHMARK_COMMON_H
@@ -0,0 +1,261 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <benchmark/benchmark.h>
+
+#include <arrow/api.h>
+#include <arrow/compute/api.h>
+#include <arrow/filesystem/api.h>
+#include <arrow/ipc/api.h>
+
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/// \brief One benchmark run, as reported by google-benchmark
+struct BenchmarkResult {
+  std::string name;
+  int64_t iterations;
+  double real_time_ns;
+  double cpu_time_ns;
+  std::optional<double> bytes_per_second;
+  std::optional<double> items_per_second;
+};
+
+/// \brief Prints results to the console like the default reporter, and keeps them
+/// so they can be written out as an Arrow table afterwards
+class CollectingReporter : public benchmark::ConsoleReporter {
+ public:
+  void ReportRuns(const std::vector<Run>& runs) override {
+    benchmark::ConsoleReporter::ReportRuns(runs);
+    for (const Run& run : runs) {
+      // Runs that were skipped with an error have no iterations
+      if (run.iterations == 0) {
+        continue;
+      }
+      double ns_per_unit = 1e9 / benchmark::GetTimeUnitMultiplier(run.time_unit);
+      BenchmarkResult result;
+      result.name = run.benchmark_name();
+      result.iterations = static_cast<int64_t>(run.iterations);
+      result.real_time_ns = run.GetAdjustedRealTime() * ns_per_unit;
+      result.cpu_time_ns = run.GetAdjustedCPUTime() * ns_per_unit;
+      result.bytes_per_second = FindCounter(run, "bytes_per_second");
+      result.items_per_second = FindCounter(run, "items_per_second");
+      results_.push_back(std::move(result));
+    }
+  }
+
+  const std::vector<BenchmarkResult>& results() const { return results_; }
+
+ private:
+  static std::optional<double> FindCounter(const Run& run, const std::string& name) {
+    auto it = run.counters.find(name);
+    if (it == run.counters.end()) {
+      return std::nullopt;
+    }
+    return it->second.value;
+  }
+
+  std::vector<BenchmarkResult> results_;
+};  // CollectingReporter
+
+using BenchmarkResultsByName = std::unordered_map<std::string, BenchmarkResult>;
+
+std::shared_ptr<arrow::Schema> BenchmarksTableSchema() {
+  return arrow::schema({arrow::field("Benchmark Name", arrow::utf8()),
+                        arrow::field("Iterations", arrow::int64()),
+                        arrow::field("Real Time (ns)", arrow::float64()),
+                        arrow::field("CPU Time (ns)", arrow::float64()),
+                        arrow::field("Bytes Per Second", arrow::float64()),
+                        arrow::field("Items Per Second", arrow::float64())});
+}
+
+arrow::Status AppendOptional(const std::optional<double>& value,
+                             arrow::DoubleBuilder* builder) {
+  if (value.has_value()) {
+    return builder->Append(*value);
+  }
+  return builder->AppendNull();
+}
+
+arrow::Result<std::shared_ptr<arrow::Table>> MakeBenchmarksTable(
+    const std::vector<BenchmarkResult>& results) {
+  arrow::StringBuilder names_builder;
+  arrow::Int64Builder iterations_builder;
+  arrow::DoubleBuilder real_times_builder;
+  arrow::DoubleBuilder cpu_times_builder;
+  arrow::DoubleBuilder bytes_per_second_builder;
+  arrow::DoubleBuilder items_per_second_builder;
+  for (const BenchmarkResult& result : results) {
+    ARROW_RETURN_NOT_OK(names_builder.Append(result.name));
+    ARROW_RETURN_NOT_OK(iterations_builder.Append(result.iterations));
+    ARROW_RETURN_NOT_OK(real_times_builder.Append(result.real_time_ns));
+    ARROW_RETURN_NOT_OK(cpu_times_builder.Append(result.cpu_time_ns));
+    ARROW_RETURN_NOT_OK(
+        AppendOptional(result.bytes_per_second, &bytes_per_second_builder));
+    ARROW_RETURN_NOT_OK(
+        AppendOptional(result.items_per_second, &items_per_second_builder));
+  }
+  std::vector<std::shared_ptr<arrow::Array>> columns(6);
+  ARROW_RETURN_NOT_OK(names_builder.Finish(&columns[0]));
+  ARROW_RETURN_NOT_OK(iterations_builder.Finish(&columns[1]));
+  ARROW_RETURN_NOT_OK(real_times_builder.Finish(&columns[2]));
+  ARROW_RETURN_NOT_OK(cpu_times_builder.Finish(&columns[3]));
+  ARROW_RETURN_NOT_OK(bytes_per_second_builder.Finish(&columns[4]));
+  ARROW_RETURN_NOT_OK(items_per_second_builder.Finish(&columns[5]));
+  std::shared_ptr<arrow::RecordBatch> batch = arrow::RecordBatch::Make(
+      BenchmarksTableSchema(), static_cast<int64_t>(results.size()), std::move(columns));
+  return arrow::Table::FromRecordBatches({batch});
+}
+
+/// \brief Read a benchmark table, keyed by benchmark name, or nothing if the file
+/// does not exist
+arrow::Result<BenchmarkResultsByName> LoadBenchmarkResults(
+    const std::string& filename) {
+  BenchmarkResultsByName results;
+  std::shared_ptr<arrow::fs::FileSystem> fs =
+      std::make_shared<arrow::fs::LocalFileSystem>();
+  arrow::Result<std::shared_ptr<arrow::io::RandomAccessFile>> maybe_in =
+      fs->OpenInputFile(filename);
+  if (!maybe_in.ok()) {
+    return results;
+  }
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::ipc::RecordBatchStreamReader> reader,
+                        arrow::ipc::RecordBatchStreamReader::Open(*maybe_in));
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Table> table, reader->ToTable());
+  if (!table->schema()->Equals(*BenchmarksTableSchema())) {
+    return arrow::Status::Invalid("Not a benchmark results table: ",
+                                  table->schema()->ToString());
+  }
+  if (table->num_rows() == 0) {
+    return results;
+  }
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::RecordBatch> batch,
+                        table->CombineChunksToBatch());
+  const arrow::StringArray& names =
+      static_cast<const arrow::StringArray&>(*batch->column(0));
+  const arrow::Int64Array& iterations =
+      static_cast<const arrow::Int64Array&>(*batch->column(1));
+  const arrow::DoubleArray& real_times =
+      static_cast<const arrow::DoubleArray&>(*batch->column(2));
+  const arrow::DoubleArray& cpu_times =
+      static_cast<const arrow::DoubleArray&>(*batch->column(3));
+  const arrow::DoubleArray& bytes_per_second =
+      static_cast<const arrow::DoubleArray&>(*batch->column(4));
+  const arrow::DoubleArray& items_per_second =
+      static_cast<const arrow::DoubleArray&>(*batch->column(5));
+  for (int64_t i = 0; i < batch->num_rows(); i++) {
+    BenchmarkResult result;
+    result.name = names.GetString(i);
+    result.iterations = iterations.Value(i);
+    result.real_time_ns = real_times.Value(i);
+    result.cpu_time_ns = cpu_times.Value(i);
+    if (bytes_per_second.IsValid(i)) result.bytes_per_second = bytes_per_second.Value(i);
+    if (items_per_second.IsValid(i)) result.items_per_second = items_per_second.Value(i);
+    results[result.name] = std::move(result);
+  }
+  return results;
+}
+
+/// \brief Print every benchmark whose CPU time per iteration grew by more than
+/// `threshold` (a fraction, e.g. 0.25 for 25%) compared to the baseline
+arrow::Status ReportRegressions(const std::vector<BenchmarkResult>& results,
+                                const std::string& baseline_filename,
+                                double threshold) {
+  ARROW_ASSIGN_OR_RAISE(BenchmarkResultsByName baseline,
+                        LoadBenchmarkResults(baseline_filename));
+  for (const BenchmarkResult& result : results) {
+    auto it = baseline.find(result.name);
+    if (it == baseline.end()) {
+      continue;
+    }
+    double before = it->second.cpu_time_ns;
+    if (result.cpu_time_ns > before * (1 + threshold)) {
+      std::cerr << "Regression in benchmark " << result.name << ": CPU time went from "
+                << before << "ns to " << result.cpu_time_ns << "ns" << std::endl;
+    }
+  }
+  return arrow::Status::OK();
+}
+
+/// \brief Merge the results of this run into `output_filename`, replacing earlier
+/// results of the same benchmarks
+arrow::Status DumpBenchmarkOutput(const std::vector<BenchmarkResult>& results,
+                                  const std::string& output_filename) {
+  ARROW_ASSIGN_OR_RAISE(BenchmarkResultsByName merged,
+                        LoadBenchmarkResults(output_filename));
+  for (const BenchmarkResult& result : results) {
+    merged[result.name] = result;
+  }
+  std::vector<BenchmarkResult> merged_results;
+  for (auto& pair : merged) {
+    merged_results.push_back(std::move(pair.second));
+  }
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Table> table,
+                        MakeBenchmarksTable(merged_results));
+  std::shared_ptr<arrow::fs::FileSystem> fs =
+      std::make_shared<arrow::fs::LocalFileSystem>();
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::io::OutputStream> out_stream,
+                        fs->OpenOutputStream(output_filename));
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::ipc::RecordBatchWriter> writer,
+                        arrow::ipc::MakeStreamWriter(out_stream.get(), table->schema()));
+  ARROW_RETURN_NOT_OK(writer->WriteTable(*table));
+  return writer->Close();
+}
+
+int main(int argc, char** argv) {
+  if (!arrow::compute::Initialize().ok()) {
+    std::cerr << "Failed to initialize Arrow compute functions" << std::endl;
+    return -1;
+  }
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  CollectingReporter reporter;
+  benchmark::RunSpecifiedBenchmarks(&reporter);
+  benchmark::Shutdown();
+  if (reporter.results().empty()) {
+    return 0;
+  }
+  // Set BENCHMARK_BASELINE to a benchmarks_out.arrow from an earlier run to report
+  // benchmarks that got slower
+  const char* baseline = std::getenv("BENCHMARK_BASELINE");
+  if (baseline != nullptr) {
+    const char* threshold = std::getenv("BENCHMARK_REGRESSION_THRESHOLD");
+    arrow::Status st = ReportRegressions(reporter.results(), baseline,
+                                         threshold ? std::atof(threshold) : 0.25);
+    if (!st.ok()) {
+      std::cerr << "Failed to compare against the baseline: " << st << std::endl;
+      return -1;
+    }
+  }
+  arrow::Status st = DumpBenchmarkOutput(reporter.results(), "benchmarks_out.arrow");
+  if (!st.ok()) {
+    std::cerr << "Benchmarks ran successfully but failed to dump their results: " << st
+              << std::endl;
+    return -1;
+  }
+  std::cout << "Created benchmark file "
+            << std::filesystem::current_path().append("benchmarks_out.arrow").string()
+            << std::endl;
+  return 0;
+}
@@ -17,58 +17,220 @@
 
 #include "common.h"
 
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <ctime>
 #include <filesystem>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <sstream>
+#include <streambuf>
+#include <thread>
 #include <unordered_map>
+#include <vector>
 
 #include "arrow/api.h"
 #include "arrow/filesystem/api.h"
 #include "arrow/ipc/api.h"
 #include "gtest/gtest.h"
 
-static arrow::StringBuilder test_names_builder;
-static arrow::StringBuilder test_output_builder;
-static std::string current_recipe;
+/// \brief The output of a recipe and what it cost to run
+struct RecipeResult {
+  std::string name;
+  std::string output;
+  double wall_time_ms;
+  // CPU time of the whole process while the recipe ran
+  double cpu_time_ms;
+  // Bytes allocated from the default memory pool by the whole process while the
+  // recipe ran
+  int64_t bytes_allocated;
+  // How far the peak memory use of the default memory pool rose while the recipe ran,
+  // or nullopt if it never went above a peak reached before it started
+  std::optional<int64_t> peak_bytes;
+};
+
+/// \brief Collects the results of recipes finished on any thread
+///
+/// Results are spread over several shards by thread so that recipes finishing on
+/// different threads rarely wait for each other.
+class RecipeResultCollector {
+ public:
+  void Add(RecipeResult result) {
+    Shard& shard = shards_[std::hash<std::thread::id>()(std::this_thread::get_id()) %
+                           kNumShards];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.results.push_back(std::move(result));
+  }
+
+  /// \brief Every result collected so far, in no particular order
+  std::vector<RecipeResult> Merge() {
+    std::vector<RecipeResult> results;
+    for (Shard& shard : shards_) {
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      results.insert(results.end(), shard.results.begin(), shard.results.end());
+    }
+    return results;
+  }
+
+  bool empty() {
+    for (Shard& shard : shards_) {
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      if (!shard.results.empty()) return false;
+    }
+    return true;
+  }
+
+ private:
+  static constexpr size_t kNumShards = 16;
+
+  struct Shard {
+    std::mutex mutex;
+    std::vector<RecipeResult> results;
+  };
+
+  std::array<Shard, kNumShards> shards_;
+};  // RecipeResultCollector
+
+/// \brief The recipe in progress on a thread and the counters when it started
+///
+/// CPU time and memory are measured for the whole process, so they include the work
+/// of any recipes running at the same time on other threads.
+struct RecipeInProgress {
+  std::string name;
+  std::chrono::steady_clock::time_point wall_start;
+  std::clock_t cpu_start;
+  int64_t bytes_in_use_start;
+  int64_t total_bytes_start;
+  int64_t max_memory_start;
+};
+
+/// \brief Where rout writes on a thread with no recipe in progress
+///
+/// Output written here would be lost, so the first write fails the test instead.
+class NoRecipeOutputBuffer : public std::streambuf {
+ protected:
+  int_type overflow(int_type ch) override {
+    ReportWrite();
+    return traits_type::not_eof(ch);
+  }
+
+  std::streamsize xsputn(const char*, std::streamsize count) override {
+    ReportWrite();
+    return count;
+  }
+
+ private:
+  void ReportWrite() {
+    if (reported_) return;
+    reported_ = true;
+    ADD_FAILURE() << "rout was written on a thread with no recipe in progress, write "
+                     "to it from the thread that called StartRecipe";
+  }
+
+  bool reported_ = false;
+};  // NoRecipeOutputBuffer
+
+static RecipeResultCollector recipe_results;
+static thread_local RecipeInProgress current_recipe;
+static thread_local NoRecipeOutputBuffer no_recipe_output;
+static thread_local std::stringbuf recipe_output;
+thread_local std::ostream rout(&no_recipe_output);
 
 void StartRecipe(const std::string& recipe_name) {
-  if (!current_recipe.empty()) {
+  if (!current_recipe.name.empty()) {
     FAIL() << "Attempt to start a recipe " << recipe_name << " but the recipe "
-           << current_recipe << " has not been marked finished";
+           << current_recipe.name << " has not been marked finished";
   }
   if (recipe_name.empty()) {
     FAIL() << "Invalid empty recipe name";
   }
-  current_recipe = recipe_name;
-  rout = std::stringstream();
+  current_recipe.name = recipe_name;
+  // Start from empty output and default formatting, whatever the last recipe did
+  recipe_output.str("");
+  rout.rdbuf(&recipe_output);
+  rout.copyfmt(std::ostream(nullptr));
+  arrow::MemoryPool* pool = arrow::default_memory_pool();
+  current_recipe.bytes_in_use_start = pool->bytes_allocated();
+  current_recipe.total_bytes_start = pool->total_bytes_allocated();
+  current_recipe.max_memory_start = pool->max_memory();
+  current_recipe.cpu_start = std::clock();
+  current_recipe.wall_start = std::chrono::steady_clock::now();
 }
 
 void EndRecipe(const std::string& recipe_name) {
-  if (current_recipe != recipe_name) {
+  std::chrono::steady_clock::time_point wall_end = std::chrono::steady_clock::now();
+  std::clock_t cpu_end = std::clock();
+  if (current_recipe.name != recipe_name) {
     FAIL() << "Attempt to end a recipe " << recipe_name
            << " but the recipe was not in progress";
   }
-  std::string recipe_output = rout.str();
-
-  ASSERT_OK(test_names_builder.Append(recipe_name));
-  ASSERT_OK(test_output_builder.Append(recipe_output));
+  arrow::MemoryPool* pool = arrow::default_memory_pool();
+  RecipeResult result;
+  result.name = recipe_name;
+  result.output = recipe_output.str();
+  result.wall_time_ms =
+      std::chrono::duration<double, std::milli>(wall_end - current_recipe.wall_start)
+          .count();
+  result.cpu_time_ms = 1000.0 * (cpu_end - current_recipe.cpu_start) / CLOCKS_PER_SEC;
+  result.bytes_allocated =
+      pool->total_bytes_allocated() - current_recipe.total_bytes_start;
+  if (pool->max_memory() > current_recipe.max_memory_start) {
+    result.peak_bytes = pool->max_memory() - current_recipe.bytes_in_use_start;
+  }
+  recipe_results.Add(std::move(result));
 
-  current_recipe = "";
+  current_recipe.name = "";
+  rout.rdbuf(&no_recipe_output);
 }
 
 std::shared_ptr<arrow::Schema> RecipesTableSchema() {
   return arrow::schema({arrow::field("Recipe Name", arrow::utf8()),
-                        arrow::field("Recipe Output", arrow::utf8())});
-}
-
-std::shared_ptr<arrow::Array> MakeEmptyStringArray() {
-  arrow::StringBuilder builder;
-  return builder.Finish().ValueOrDie();
+                        arrow::field("Recipe Output", arrow::utf8()),
+                        arrow::field("Wall Time (ms)", arrow::float64()),
+                        arrow::field("Process CPU Time (ms)", arrow::float64()),
+                        arrow::field("Process Bytes Allocated", arrow::int64()),
+                        arrow::field("Process Peak Bytes", arrow::int64())});
 }
 
-arrow::Result<std::shared_ptr<arrow::Table>> MakeEmptyRecipesTable() {
-  std::shared_ptr<arrow::Schema> schema = RecipesTableSchema();
+arrow::Result<std::shared_ptr<arrow::Table>> MakeRecipesTable(
+    const std::vector<RecipeResult>& results) {
+  arrow::StringBuilder names_builder;
+  arrow::StringBuilder outputs_builder;
+  arrow::DoubleBuilder wall_times_builder;
+  arrow::DoubleBuilder cpu_times_builder;
+  arrow::Int64Builder bytes_allocated_builder;
+  arrow::Int64Builder peak_bytes_builder;
+  for (const RecipeResult& result : results) {
+    ARROW_RETURN_NOT_OK(names_builder.Append(result.name));
+    ARROW_RETURN_NOT_OK(outputs_builder.Append(result.output));
+    ARROW_RETURN_NOT_OK(wall_times_builder.Append(result.wall_time_ms));
+    ARROW_RETURN_NOT_OK(cpu_times_builder.Append(result.cpu_time_ms));
+    ARROW_RETURN_NOT_OK(bytes_allocated_builder.Append(result.bytes_allocated));
+    if (result.peak_bytes.has_value()) {
+      ARROW_RETURN_NOT_OK(peak_bytes_builder.Append(*result.peak_bytes));
+    } else {
+      ARROW_RETURN_NOT_OK(peak_bytes_builder.AppendNull());
+    }
+  }
+  std::vector<std::shared_ptr<arrow::Array>> columns(6);
+  ARROW_RETURN_NOT_OK(names_builder.Finish(&columns[0]));
+  ARROW_RETURN_NOT_OK(outputs_builder.Finish(&columns[1]));
+  ARROW_RETURN_NOT_OK(wall_times_builder.Finish(&columns[2]));
+  ARROW_RETURN_NOT_OK(cpu_times_builder.Finish(&columns[3]));
+  ARROW_RETURN_NOT_OK(bytes_allocated_builder.Finish(&columns[4]));
+  ARROW_RETURN_NOT_OK(peak_bytes_builder.Finish(&columns[5]));
   std::shared_ptr<arrow::RecordBatch> batch = arrow::RecordBatch::Make(
-      schema, 0, {MakeEmptyStringArray(), MakeEmptyStringArray()});
+      RecipesTableSchema(), static_cast<int64_t>(results.size()), std::move(columns));
   return arrow::Table::FromRecordBatches({batch});
 }
 
@@ -86,65 +248,195 @@ arrow::Result<std::shared_ptr<arrow::Table>> LoadExistingRecipeOutputTable(
   arrow::Result<std::shared_ptr<arrow::io::RandomAccessFile>> maybe_in =
       fs->OpenInputFile(filename);
   if (!maybe_in.ok()) {
-    return MakeEmptyRecipesTable();
+    return MakeRecipesTable({});
   }
   std::shared_ptr<arrow::io::RandomAccessFile> in = *maybe_in;
   return ReadRecipeTable(in);
 }
 
-arrow::Result<std::shared_ptr<arrow::Table>> CreateRecipeOutputTable() {
-  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Array> test_names,
-                        test_names_builder.Finish());
-  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Array> test_outputs,
-                        test_output_builder.Finish());
-  std::shared_ptr<arrow::Schema> schema =
-      arrow::schema({arrow::field("Recipe Name", arrow::utf8()),
-                     arrow::field("Recipe Output", arrow::utf8())});
-  std::shared_ptr<arrow::RecordBatch> batch =
-      arrow::RecordBatch::Make(schema, test_names->length(), {test_names, test_outputs});
-  return arrow::Table::FromRecordBatches({batch});
+/// \brief The column called `name`, or `old_name` in tables written before the
+/// process-wide metrics were labelled as such
+std::shared_ptr<arrow::Array> GetMetricColumn(const arrow::RecordBatch& batch,
+                                              const std::string& name,
+                                              const std::string& old_name) {
+  std::shared_ptr<arrow::Array> column = batch.GetColumnByName(name);
+  return column != nullptr ? column : batch.GetColumnByName(old_name);
 }
 
-void PopulateMap(const arrow::Table& table,
-                 std::unordered_map<std::string, std::string>* values) {
+/// \brief Read the results in a recipe table, keyed by recipe name
+///
+/// Columns are looked up by name, so tables written before the timing and memory
+/// columns were added can still be read.  Their metrics read as zero.
+arrow::Status PopulateMap(const arrow::Table& table,
+                          std::unordered_map<std::string, RecipeResult>* values) {
   if (table.num_rows() == 0) {
-    return;
+    return arrow::Status::OK();
   }
-  std::shared_ptr<arrow::StringArray> table_names =
-      std::dynamic_pointer_cast<arrow::StringArray>(table.column(0)->chunk(0));
-  std::shared_ptr<arrow::StringArray> table_outputs =
-      std::dynamic_pointer_cast<arrow::StringArray>(table.column(1)->chunk(0));
-  for (int64_t i = 0; i < table.num_rows(); i++) {
-    (*values)[table_names->GetString(i)] = table_outputs->GetString(i);
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::RecordBatch> batch,
+                        table.CombineChunksToBatch());
+  std::shared_ptr<arrow::StringArray> names =
+      std::dynamic_pointer_cast<arrow::StringArray>(
+          batch->GetColumnByName("Recipe Name"));
+  std::shared_ptr<arrow::StringArray> outputs =
+      std::dynamic_pointer_cast<arrow::StringArray>(
+          batch->GetColumnByName("Recipe Output"));
+  if (names == nullptr || outputs == nullptr) {
+    return arrow::Status::Invalid("Not a recipe output table: ",
+                                  table.schema()->ToString());
+  }
+  std::shared_ptr<arrow::DoubleArray> wall_times =
+      std::dynamic_pointer_cast<arrow::DoubleArray>(
+          batch->GetColumnByName("Wall Time (ms)"));
+  std::shared_ptr<arrow::DoubleArray> cpu_times =
+      std::dynamic_pointer_cast<arrow::DoubleArray>(
+          GetMetricColumn(*batch, "Process CPU Time (ms)", "CPU Time (ms)"));
+  std::shared_ptr<arrow::Int64Array> bytes_allocated =
+      std::dynamic_pointer_cast<arrow::Int64Array>(
+          GetMetricColumn(*batch, "Process Bytes Allocated", "Bytes Allocated"));
+  std::shared_ptr<arrow::Int64Array> peak_bytes =
+      std::dynamic_pointer_cast<arrow::Int64Array>(
+          GetMetricColumn(*batch, "Process Peak Bytes", "Peak Bytes"));
+  for (int64_t i = 0; i < batch->num_rows(); i++) {
+    RecipeResult result;
+    result.name = names->GetString(i);
+    result.output = outputs->GetString(i);
+    result.wall_time_ms = wall_times ? wall_times->Value(i) : 0;
+    result.cpu_time_ms = cpu_times ? cpu_times->Value(i) : 0;
+    result.bytes_allocated = bytes_allocated ? bytes_allocated->Value(i) : 0;
+    if (peak_bytes && peak_bytes->IsValid(i)) {
+      result.peak_bytes = peak_bytes->Value(i);
+    }
+    (*values)[result.name] = std::move(result);
   }
+  return arrow::Status::OK();
 }
 
 arrow::Result<std::shared_ptr<arrow::Table>> MergeRecipeTables(
     const std::shared_ptr<arrow::Table>& old_table,
     const std::shared_ptr<arrow::Table>& new_table) {
-  std::unordered_map<std::string, std::string> values;
-  PopulateMap(*old_table, &values);
-  PopulateMap(*new_table, &values);
-  arrow::StringBuilder names_builder;
-  arrow::StringBuilder outputs_builder;
-  for (const auto& pair : values) {
-    ARROW_RETURN_NOT_OK(names_builder.Append(pair.first));
-    ARROW_RETURN_NOT_OK(outputs_builder.Append(pair.second));
-  }
-  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Array> names_arr, names_builder.Finish());
-  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Array> outputs_arr,
-                        outputs_builder.Finish());
-  std::shared_ptr<arrow::Schema> schema = RecipesTableSchema();
-  std::shared_ptr<arrow::RecordBatch> batch =
-      arrow::RecordBatch::Make(schema, names_arr->length(), {names_arr, outputs_arr});
-  return arrow::Table::FromRecordBatches({batch});
+  std::unordered_map<std::string, RecipeResult> values;
+  ARROW_RETURN_NOT_OK(PopulateMap(*old_table, &values));
+  ARROW_RETURN_NOT_OK(PopulateMap(*new_table, &values));
+  std::vector<RecipeResult> merged;
+  for (auto& pair : values) {
+    merged.push_back(std::move(pair.second));
+  }
+  return MakeRecipesTable(merged);
+}
+
+/// \brief Describe how much worse a metric got, or return nullopt if it did not
+///
+/// Values that stay below `minimum` are too noisy to compare and are ignored.
+std::optional<std::string> DescribeRegression(const std::string& metric, double baseline,
+                                              double current, double threshold,
+                                              double minimum) {
+  if (std::max(baseline, current) < minimum || current <= baseline * (1 + threshold)) {
+    return std::nullopt;
+  }
+  std::stringstream description;
+  description << metric << " went from " << baseline << " to " << current;
+  if (baseline > 0) {
+    description << " (+" << static_cast<int>(100 * (current / baseline - 1)) << "%)";
+  }
+  return description.str();
+}
+
+/// \brief Print every recipe in this run that got slower or used more memory than in
+/// the baseline by more than `threshold` (a fraction, e.g. 0.25 for 25%)
+///
+/// A baseline that does not exist yet has no recipes to compare with.
+arrow::Status ReportRegressions(const std::string& baseline_filename,
+                                double threshold) {
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Table> baseline_table,
+                        LoadExistingRecipeOutputTable(baseline_filename));
+  std::unordered_map<std::string, RecipeResult> baseline;
+  ARROW_RETURN_NOT_OK(PopulateMap(*baseline_table, &baseline));
+  for (const RecipeResult& current : recipe_results.Merge()) {
+    auto it = baseline.find(current.name);
+    if (it == baseline.end()) {
+      continue;
+    }
+    const RecipeResult& before = it->second;
+    std::vector<std::optional<std::string>> regressions = {
+        DescribeRegression("wall time (ms)", before.wall_time_ms, current.wall_time_ms,
+                           threshold, /*minimum=*/1),
+        DescribeRegression("CPU time (ms)", before.cpu_time_ms, current.cpu_time_ms,
+                           threshold, /*minimum=*/1),
+        DescribeRegression("bytes allocated", static_cast<double>(before.bytes_allocated),
+                           static_cast<double>(current.bytes_allocated), threshold,
+                           /*minimum=*/0)};
+    if (before.peak_bytes.has_value() && current.peak_bytes.has_value()) {
+      regressions.push_back(DescribeRegression(
+          "peak bytes", static_cast<double>(*before.peak_bytes),
+          static_cast<double>(*current.peak_bytes), threshold, /*minimum=*/0));
+    }
+    for (const std::optional<std::string>& regression : regressions) {
+      if (regression.has_value()) {
+        std::cerr << "Regression in recipe " << current.name << ": " << *regression
+                  << std::endl;
+      }
+    }
+  }
+  return arrow::Status::OK();
 }
 
-bool HasRecipeOutput() { return test_names_builder.length() > 0; }
+bool HasRecipeOutput() { return !recipe_results.empty(); }
+
+/// \brief Holds a lock on a file shared between processes for as long as it lives
+///
+/// The lock is an advisory lock on a file next to `filename`.  The operating system
+/// releases it when the process exits, so a crashed test never leaves it behind.
+class ScopedFileLock {
+ public:
+  static arrow::Result<std::unique_ptr<ScopedFileLock>> Acquire(
+      const std::string& filename) {
+    std::string lock_path = filename + ".lock";
+    int fd = open(lock_path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0 && errno == EISDIR) {
+      // Earlier versions locked by creating a directory, which a crash left behind
+      std::error_code error;
+      std::filesystem::remove(lock_path, error);
+      fd = open(lock_path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    }
+    if (fd < 0) {
+      return arrow::Status::IOError("Failed to open ", lock_path, ": ",
+                                    std::strerror(errno));
+    }
+    while (flock(fd, LOCK_EX) != 0) {
+      if (errno != EINTR) {
+        int error = errno;
+        close(fd);
+        return arrow::Status::IOError("Failed to lock ", lock_path, ": ",
+                                      std::strerror(error));
+      }
+    }
+    return std::unique_ptr<ScopedFileLock>(new ScopedFileLock(fd));
+  }
+
+  ~ScopedFileLock() {
+    // The lock file itself is left in place, removing it could let two processes
+    // lock different files with the same name
+    flock(fd_, LOCK_UN);
+    close(fd_);
+  }
 
-arrow::Status DumpRecipeOutput(const std::string& output_filename) {
+ private:
+  explicit ScopedFileLock(int fd) : fd_(fd) {}
+
+  int fd_;
+};  // ScopedFileLock
+
+arrow::Status DumpRecipeOutput(const std::string& output_filename,
+                               const std::string& baseline_filename,
+                               double regression_threshold) {
+  if (!baseline_filename.empty()) {
+    ARROW_RETURN_NOT_OK(ReportRegressions(baseline_filename, regression_threshold));
+  }
   ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Table> new_table,
-                        CreateRecipeOutputTable());
+                        MakeRecipesTable(recipe_results.Merge()));
+  // Test binaries run in parallel by ctest all merge into the same file
+  ARROW_ASSIGN_OR_RAISE(std::unique_ptr<ScopedFileLock> lock,
+                        ScopedFileLock::Acquire(output_filename));
   ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Table> old_table,
                         LoadExistingRecipeOutputTable(output_filename));
   ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Table> merged_table,
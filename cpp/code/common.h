@@ -20,14 +20,29 @@
 
 #include <arrow/testing/gtest_util.h>
 
-#include <sstream>
+#include <ostream>
 #include <string>
 
-inline std::stringstream rout;
+/// \brief Output of the recipe in progress on this thread
+///
+/// Every thread has its own recipe state, so recipes can run on several threads at
+/// once.  Only the thread that called StartRecipe may write to rout, there is no
+/// telling which recipe output written on any other thread belongs to.  Writing to
+/// rout on a thread with no recipe in progress, e.g. from a task on a thread pool,
+/// fails the test; hand the results back to the recipe's thread instead.
+extern thread_local std::ostream rout;
 
 void StartRecipe(const std::string& recipe_name);
 void EndRecipe(const std::string& recipe_name);
-arrow::Status DumpRecipeOutput(const std::string& output_filename);
+/// \brief Write the output, timings and memory use of every recipe that ran
+///
+/// Results are merged into `output_filename` if it already exists.  If
+/// `baseline_filename` is given and exists, any recipe that got slower or allocated
+/// more than in the baseline by more than `regression_threshold` is reported on
+/// stderr.  CPU time and memory are measured for the whole process.
+arrow::Status DumpRecipeOutput(const std::string& output_filename,
+                               const std::string& baseline_filename = "",
+                               double regression_threshold = 0.25);
 bool HasRecipeOutput();
 arrow::Result<std::string> FindTestDataFile(const std::string& test_data_name);
 
@@ -16,11 +16,31 @@
 // under the License.
 
 #include <arrow/api.h>
+#include <arrow/io/interfaces.h>
+#include <arrow/util/async_generator.h>
+#include <arrow/util/bitmap_generate.h>
+#include <arrow/util/byte_size.h>
+#include <arrow/util/thread_pool.h>
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <list>
+#include <mutex>
 #include <random>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "common.h"
+#include "creating_arrow_objects.h"
 
 arrow::Status CreatingArrays() {
   StartRecipe("CreatingArrays");
@@ -146,6 +166,1111 @@ arrow::Status GenerateRandomData() {
   return arrow::Status::OK();
 }
 
+/// \brief A small and fast pseudo random number generator (SplitMix64)
+///
+/// Much cheaper than std::mt19937 and good enough for test data.
+class FastRandom {
+  uint64_t state;
+
+ public:
+  explicit FastRandom(uint64_t seed) : state(seed) {}
+
+  uint64_t Next() {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+  }
+
+  /// \brief A uniformly distributed double in [0, 1)
+  double NextDouble() { return static_cast<double>(Next() >> 11) * 0x1.0p-53; }
+};
+
+struct RandomDataOptions {
+  enum class Distribution {
+    /// Numbers spread evenly over the whole range of the type
+    kUniform,
+    /// Numbers in [0, cardinality) clustered around cardinality / 2
+    kNormal,
+    /// Numbers in [0, cardinality) where small numbers are far more common
+    kZipf,
+    /// Uniform numbers in [0, cardinality), sorted in runs of run_length values
+    kSortedRuns,
+  };
+
+  /// Generators with the same seed generate the same batches
+  uint64_t seed = 42;
+  /// How numbers and dictionary indices are distributed, kSortedRuns also sorts
+  /// timestamps
+  Distribution distribution = Distribution::kUniform;
+  /// Number of distinct numbers, for all distributions except kUniform
+  int64_t cardinality = 1000;
+  /// Skew of the kZipf distribution, larger is more skewed
+  double zipf_exponent = 1.1;
+  /// Length of each sorted run of the kSortedRuns distribution
+  int64_t run_length = 1024;
+  /// Probability that a value of a nullable field is null
+  double null_probability = 0.0;
+  /// Average length of strings, binary values and lists
+  int32_t mean_length = 8;
+  /// Number of values in the dictionary of dictionary encoded fields
+  int32_t dictionary_size = 16;
+
+  arrow::Status Validate() const {
+    if (cardinality <= 0) {
+      return arrow::Status::Invalid("cardinality must be positive, got ", cardinality);
+    }
+    if (run_length <= 0) {
+      return arrow::Status::Invalid("run_length must be positive, got ", run_length);
+    }
+    if (!(null_probability >= 0 && null_probability <= 1)) {
+      return arrow::Status::Invalid("null_probability must be in [0, 1], got ",
+                                    null_probability);
+    }
+    if (mean_length < 0) {
+      return arrow::Status::Invalid("mean_length must not be negative, got ",
+                                    mean_length);
+    }
+    if (dictionary_size <= 0) {
+      return arrow::Status::Invalid("dictionary_size must be positive, got ",
+                                    dictionary_size);
+    }
+    return arrow::Status::OK();
+  }
+};  // RandomDataOptions
+
+/// \brief Generate a random array by filling its buffers directly
+///
+/// Values are written straight into preallocated buffers instead of being
+/// appended one at a time with a builder.  Nested fields are generated by child
+/// generators with their own seeds.
+class RandomArrayGenerator {
+ public:
+  RandomArrayGenerator(const RandomDataOptions& options, uint64_t seed)
+      : options_(options), rng_(seed) {}
+
+  arrow::Result<std::shared_ptr<arrow::ArrayData>> Generate(
+      const std::shared_ptr<arrow::DataType>& type, int64_t length, bool nullable) {
+    type_ = type;
+    length_ = length;
+    null_count_ = 0;
+    validity_ = nullptr;
+    if (nullable && options_.null_probability > 0) {
+      ARROW_ASSIGN_OR_RAISE(validity_, arrow::AllocateBitmap(length));
+      arrow::internal::GenerateBitsUnrolled(validity_->mutable_data(), 0, length, [&]() {
+        bool valid = rng_.NextDouble() >= options_.null_probability;
+        null_count_ += !valid;
+        return valid;
+      });
+    }
+    ARROW_RETURN_NOT_OK(arrow::VisitTypeInline(*type, this));
+    return std::move(result_);
+  }
+
+  // Default implementation
+  arrow::Status Visit(const arrow::DataType& type) {
+    return arrow::Status::NotImplemented("Generating data for ", type.ToString());
+  }
+
+  arrow::Status Visit(const arrow::BooleanType&) {
+    ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Buffer> values,
+                          arrow::AllocateBitmap(length_));
+    arrow::internal::GenerateBitsUnrolled(values->mutable_data(), 0, length_,
+                                          [&]() { return (rng_.Next() & 1) == 1; });
+    return Finish({validity_, values});
+  }
+
+  template <typename T>
+  arrow::enable_if_integer<T, arrow::Status> Visit(const T&) {
+    using CType = typename T::c_type;
+    if (!IsUniform()) {
+      double cardinality = static_cast<double>(options_.cardinality);
+      return FillValues<CType>([&]() { return static_cast<CType>(Sample(cardinality)); });
+    }
+    return FillValues<CType>([&]() { return static_cast<CType>(rng_.Next()); });
+  }
+
+  arrow::Status Visit(const arrow::FloatType&) {
+    if (!IsUniform()) {
+      double cardinality = static_cast<double>(options_.cardinality);
+      return FillValues<float>([&]() { return static_cast<float>(Sample(cardinality)); });
+    }
+    return FillValues<float>(
+        [&]() { return static_cast<float>(rng_.NextDouble() * 200 - 100); });
+  }
+
+  arrow::Status Visit(const arrow::DoubleType&) {
+    if (!IsUniform()) {
+      double cardinality = static_cast<double>(options_.cardinality);
+      return FillValues<double>([&]() { return Sample(cardinality); });
+    }
+    return FillValues<double>([&]() { return rng_.NextDouble() * 200 - 100; });
+  }
+
+  arrow::Status Visit(const arrow::TimestampType& type) {
+    // Between 2000-01-01 and 2030-01-01
+    constexpr int64_t kStartSeconds = 946684800;
+    constexpr int64_t kEndSeconds = 1893456000;
+    int64_t units_per_second = 1;
+    switch (type.unit()) {
+      case arrow::TimeUnit::SECOND:
+        break;
+      case arrow::TimeUnit::MILLI:
+        units_per_second = 1000;
+        break;
+      case arrow::TimeUnit::MICRO:
+        units_per_second = 1000000;
+        break;
+      case arrow::TimeUnit::NANO:
+        units_per_second = 1000000000;
+        break;
+    }
+    uint64_t range =
+        static_cast<uint64_t>((kEndSeconds - kStartSeconds) * units_per_second);
+    return FillValues<int64_t>([&]() {
+      return kStartSeconds * units_per_second + static_cast<int64_t>(rng_.Next() % range);
+    });
+  }
+
+  template <typename T>
+  arrow::enable_if_base_binary<T, arrow::Status> Visit(const T&) {
+    using OffsetType = typename T::offset_type;
+    ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Buffer> offsets,
+                          GenerateOffsets<OffsetType>());
+    int64_t data_length = offsets->data_as<OffsetType>()[length_];
+    ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Buffer> data,
+                          arrow::AllocateBuffer(data_length));
+    uint8_t* out = data->mutable_data();
+    // Lower case letters are valid UTF-8, so this works for strings and binary
+    for (int64_t i = 0; i < data_length; i++) {
+      out[i] = static_cast<uint8_t>('a' + rng_.Next() % 26);
+    }
+    return Finish({validity_, offsets, data});
+  }
+
+  template <typename T>
+  arrow::enable_if_t<std::is_same<T, arrow::ListType>::value ||
+                         std::is_same<T, arrow::LargeListType>::value,
+                     arrow::Status>
+  Visit(const T& type) {
+    using OffsetType = typename T::offset_type;
+    ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Buffer> offsets,
+                          GenerateOffsets<OffsetType>());
+    int64_t num_values = offsets->data_as<OffsetType>()[length_];
+    RandomArrayGenerator value_generator(options_, rng_.Next());
+    ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::ArrayData> values,
+                          value_generator.Generate(type.value_type(), num_values,
+                                                   type.value_field()->nullable()));
+    return Finish({validity_, offsets}, {values});
+  }
+
+  arrow::Status Visit(const arrow::StructType& type) {
+    std::vector<std::shared_ptr<arrow::ArrayData>> children;
+    for (const std::shared_ptr<arrow::Field>& field : type.fields()) {
+      RandomArrayGenerator child_generator(options_, rng_.Next());
+      ARROW_ASSIGN_OR_RAISE(
+          std::shared_ptr<arrow::ArrayData> child,
+          child_generator.Generate(field->type(), length_, field->nullable()));
+      children.push_back(std::move(child));
+    }
+    return Finish({validity_}, std::move(children));
+  }
+
+  arrow::Status Visit(const arrow::DictionaryType& type) {
+    RandomArrayGenerator dictionary_generator(options_, rng_.Next());
+    ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::ArrayData> dictionary,
+                          dictionary_generator.Generate(type.value_type(),
+                                                        options_.dictionary_size,
+                                                        /*nullable=*/false));
+    uint64_t dictionary_size = static_cast<uint64_t>(options_.dictionary_size);
+    switch (type.index_type()->id()) {
+      case arrow::Type::INT8:
+        ARROW_RETURN_NOT_OK(FillValues<int8_t>(
+            [&]() { return static_cast<int8_t>(NextIndex(dictionary_size)); }));
+        break;
+      case arrow::Type::INT16:
+        ARROW_RETURN_NOT_OK(FillValues<int16_t>(
+            [&]() { return static_cast<int16_t>(NextIndex(dictionary_size)); }));
+        break;
+      case arrow::Type::INT32:
+        ARROW_RETURN_NOT_OK(FillValues<int32_t>(
+            [&]() { return static_cast<int32_t>(NextIndex(dictionary_size)); }));
+        break;
+      case arrow::Type::INT64:
+        ARROW_RETURN_NOT_OK(FillValues<int64_t>(
+            [&]() { return static_cast<int64_t>(NextIndex(dictionary_size)); }));
+        break;
+      default:
+        return arrow::Status::NotImplemented("Generating indices of type ",
+                                             type.index_type()->ToString());
+    }
+    result_->dictionary = std::move(dictionary);
+    return arrow::Status::OK();
+  }
+
+ private:
+  template <typename CType, typename NextValue>
+  arrow::Status FillValues(NextValue&& next_value) {
+    ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Buffer> values,
+                          arrow::AllocateBuffer(length_ * sizeof(CType)));
+    CType* out = values->mutable_data_as<CType>();
+    // Null slots get a value too, so that the same seed always gives the same bytes
+    for (int64_t i = 0; i < length_; i++) {
+      out[i] = next_value();
+    }
+    if (options_.distribution == RandomDataOptions::Distribution::kSortedRuns) {
+      for (int64_t start = 0; start < length_; start += options_.run_length) {
+        std::sort(out + start, out + std::min(length_, start + options_.run_length));
+      }
+    }
+    return Finish({validity_, values});
+  }
+
+  bool IsUniform() const {
+    return options_.distribution == RandomDataOptions::Distribution::kUniform;
+  }
+
+  /// \brief A number in [0, cardinality) drawn from the configured distribution
+  double Sample(double cardinality) {
+    switch (options_.distribution) {
+      case RandomDataOptions::Distribution::kNormal: {
+        // Box-Muller transform, clamped to the range
+        constexpr double kPi = 3.14159265358979323846;
+        double radius = std::sqrt(-2.0 * std::log(1.0 - rng_.NextDouble()));
+        double z = radius * std::cos(2 * kPi * rng_.NextDouble());
+        return std::clamp(cardinality / 2 + z * cardinality / 6, 0.0,
+                          std::nextafter(cardinality, 0.0));
+      }
+      case RandomDataOptions::Distribution::kZipf: {
+        // Invert the CDF of a power law on [1, cardinality + 1), which is a close
+        // approximation of the Zipf distribution that needs no lookup table
+        double s = options_.zipf_exponent;
+        double u = rng_.NextDouble();
+        double x = s == 1.0 ? std::pow(cardinality + 1, u)
+                            : std::pow((std::pow(cardinality + 1, 1 - s) - 1) * u + 1,
+                                       1 / (1 - s));
+        return std::min(x - 1, std::nextafter(cardinality, 0.0));
+      }
+      default:
+        return rng_.NextDouble() * cardinality;
+    }
+  }
+
+  /// \brief An index in [0, size) drawn from the configured distribution
+  uint64_t NextIndex(uint64_t size) {
+    if (IsUniform()) return rng_.Next() % size;
+    return static_cast<uint64_t>(Sample(static_cast<double>(size)));
+  }
+
+  /// \brief Generate offsets for values of random length, null values are empty
+  template <typename OffsetType>
+  arrow::Result<std::shared_ptr<arrow::Buffer>> GenerateOffsets() {
+    ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Buffer> offsets,
+                          arrow::AllocateBuffer((length_ + 1) * sizeof(OffsetType)));
+    OffsetType* out = offsets->mutable_data_as<OffsetType>();
+    uint64_t max_length = 2 * static_cast<uint64_t>(options_.mean_length) + 1;
+    int64_t total = 0;
+    out[0] = 0;
+    for (int64_t i = 0; i < length_; i++) {
+      int64_t value_length = static_cast<int64_t>(rng_.Next() % max_length);
+      if (validity_ != nullptr && !arrow::bit_util::GetBit(validity_->data(), i)) {
+        value_length = 0;
+      }
+      total += value_length;
+      out[i + 1] = static_cast<OffsetType>(total);
+    }
+    if (total > std::numeric_limits<OffsetType>::max()) {
+      return arrow::Status::CapacityError("Generated values do not fit in ",
+                                          type_->ToString());
+    }
+    return offsets;
+  }
+
+  arrow::Status Finish(std::vector<std::shared_ptr<arrow::Buffer>> buffers,
+                       std::vector<std::shared_ptr<arrow::ArrayData>> children = {}) {
+    result_ = arrow::ArrayData::Make(type_, length_, std::move(buffers),
+                                     std::move(children), null_count_);
+    return arrow::Status::OK();
+  }
+
+  RandomDataOptions options_;
+  FastRandom rng_;
+  std::shared_ptr<arrow::DataType> type_;
+  int64_t length_ = 0;
+  int64_t null_count_ = 0;
+  std::shared_ptr<arrow::Buffer> validity_;
+  std::shared_ptr<arrow::ArrayData> result_;
+};  // RandomArrayGenerator
+
+/// \brief Generate reproducible random record batches, one column per task
+///
+/// Each column is generated on `executor` with a seed derived from the options'
+/// seed, so the batches are the same no matter how many threads are used.
+class BulkRandomBatchGenerator {
+ public:
+  BulkRandomBatchGenerator(std::shared_ptr<arrow::Schema> schema,
+                           RandomDataOptions options = {})
+      : schema_(std::move(schema)), options_(options), seeds_(options.seed) {}
+
+  /// \brief Start generating `num_rows` rows, the batch is ready once every column is
+  arrow::Future<std::shared_ptr<arrow::RecordBatch>> GenerateAsync(
+      int64_t num_rows,
+      arrow::internal::Executor* executor = arrow::internal::GetCpuThreadPool()) {
+    arrow::Status valid = options_.Validate();
+    if (!valid.ok()) {
+      return arrow::Future<std::shared_ptr<arrow::RecordBatch>>::MakeFinished(
+          std::move(valid));
+    }
+    std::vector<arrow::Future<std::shared_ptr<arrow::ArrayData>>> columns;
+    for (const std::shared_ptr<arrow::Field>& field : schema_->fields()) {
+      uint64_t seed = seeds_.Next();
+      RandomDataOptions options = options_;
+      columns.push_back(arrow::DeferNotOk(executor->Submit(
+          [options, seed, field,
+           num_rows]() -> arrow::Result<std::shared_ptr<arrow::ArrayData>> {
+            RandomArrayGenerator generator(options, seed);
+            return generator.Generate(field->type(), num_rows, field->nullable());
+          })));
+    }
+
+    std::shared_ptr<arrow::Schema> schema = schema_;
+    return arrow::All(std::move(columns))
+        .Then([schema, num_rows](
+                  const std::vector<arrow::Result<std::shared_ptr<arrow::ArrayData>>>&
+                      results) -> arrow::Result<std::shared_ptr<arrow::RecordBatch>> {
+          std::vector<std::shared_ptr<arrow::ArrayData>> column_data;
+          for (const arrow::Result<std::shared_ptr<arrow::ArrayData>>& result :
+               results) {
+            ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::ArrayData> data, result);
+            column_data.push_back(std::move(data));
+          }
+          return arrow::RecordBatch::Make(schema, num_rows, std::move(column_data));
+        });
+  }
+
+  /// \brief Generate `num_rows` rows and wait for them
+  ///
+  /// Waiting on a thread of `executor` could leave the columns with no thread to run
+  /// on, so tasks running on `executor` must use GenerateAsync instead.
+  arrow::Result<std::shared_ptr<arrow::RecordBatch>> Generate(
+      int64_t num_rows,
+      arrow::internal::Executor* executor = arrow::internal::GetCpuThreadPool()) {
+    if (executor->OwnsThisThread()) {
+      return arrow::Status::Invalid(
+          "Generate cannot wait on its own executor, use GenerateAsync");
+    }
+    return GenerateAsync(num_rows, executor).result();
+  }
+
+ private:
+  std::shared_ptr<arrow::Schema> schema_;
+  RandomDataOptions options_;
+  FastRandom seeds_;
+};  // BulkRandomBatchGenerator
+
+arrow::Status GenerateRandomDataInBulk() {
+  StartRecipe("GenerateRandomDataInBulk");
+  std::shared_ptr<arrow::Schema> schema = arrow::schema({
+      arrow::field("id", arrow::int32(), /*nullable=*/false),
+      arrow::field("value", arrow::float64()),
+      arrow::field("name", arrow::utf8()),
+      arrow::field("time", arrow::timestamp(arrow::TimeUnit::MILLI)),
+      arrow::field("category", arrow::dictionary(arrow::int8(), arrow::utf8())),
+      arrow::field("point", arrow::struct_({arrow::field("x", arrow::float32()),
+                                            arrow::field("y", arrow::float32())})),
+      arrow::field("tags", arrow::list(arrow::utf8())),
+      arrow::field("payload", arrow::large_binary()),
+  });
+  RandomDataOptions options;
+  options.seed = 1234;
+  options.null_probability = 0.2;
+  options.mean_length = 2;
+  options.dictionary_size = 4;
+
+  BulkRandomBatchGenerator generator(schema, options);
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::RecordBatch> batch, generator.Generate(3));
+  ARROW_RETURN_NOT_OK(batch->ValidateFull());
+  rout << "Created batch: \n" << batch->ToString();
+  EndRecipe("GenerateRandomDataInBulk");
+
+  // The same seed gives the same data, however many threads are used
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::internal::ThreadPool> one_thread,
+                        arrow::internal::ThreadPool::Make(1));
+  BulkRandomBatchGenerator serial_generator(schema, options);
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::RecordBatch> serial_batch,
+                        serial_generator.Generate(3, one_thread.get()));
+  EXPECT_TRUE(batch->Equals(*serial_batch));
+
+  // Waiting for the columns on the only thread that can generate them would hang
+  arrow::Future<> nested = arrow::DeferNotOk(one_thread->Submit(
+      [&]() { return serial_generator.Generate(3, one_thread.get()).status(); }));
+  EXPECT_TRUE(nested.status().IsInvalid());
+
+  // Options that would divide by zero or never finish a run are rejected
+  std::vector<std::pair<std::string, std::function<void(RandomDataOptions*)>>>
+      invalid_options = {
+          {"run_length", [](RandomDataOptions* o) { o->run_length = 0; }},
+          {"dictionary_size", [](RandomDataOptions* o) { o->dictionary_size = 0; }},
+          {"cardinality", [](RandomDataOptions* o) { o->cardinality = 0; }},
+          {"null_probability", [](RandomDataOptions* o) { o->null_probability = 1.5; }},
+          {"mean_length", [](RandomDataOptions* o) { o->mean_length = -1; }},
+      };
+  for (const std::pair<std::string, std::function<void(RandomDataOptions*)>>&
+           make_invalid : invalid_options) {
+    RandomDataOptions invalid = options;
+    make_invalid.second(&invalid);
+    BulkRandomBatchGenerator invalid_generator(schema, invalid);
+    EXPECT_TRUE(invalid_generator.Generate(3).status().IsInvalid()) << make_invalid.first;
+  }
+  return arrow::Status::OK();
+}
+
+arrow::Result<std::shared_ptr<arrow::RecordBatch>> GenerateRandomRowsByAppending(
+    std::shared_ptr<arrow::Schema> schema, int32_t num_rows) {
+  RandomBatchGenerator generator(std::move(schema));
+  return generator.Generate(num_rows);
+}
+
+arrow::Result<std::shared_ptr<arrow::RecordBatch>> GenerateRandomRowsInBulk(
+    std::shared_ptr<arrow::Schema> schema, int64_t num_rows) {
+  BulkRandomBatchGenerator generator(std::move(schema));
+  return generator.Generate(num_rows);
+}
+
+/// \brief A stream of random batches of roughly the same size in bytes
+///
+/// The next batch is generated in the background while the current one is being
+/// consumed, so a fast consumer is not held up by the generator.  The stream can
+/// be limited to a number of rows per second to simulate a steady load, and to a
+/// total number of rows.  Otherwise it never ends.
+class RandomBatchReader : public arrow::RecordBatchReader {
+ public:
+  static arrow::Result<std::shared_ptr<RandomBatchReader>> Make(
+      std::shared_ptr<arrow::Schema> schema, RandomDataOptions options,
+      int64_t target_batch_bytes, double max_rows_per_second = 0,
+      int64_t max_rows = -1) {
+    // Measure a sample batch to find out how many rows make up the target size
+    constexpr int64_t kSampleRows = 1024;
+    BulkRandomBatchGenerator sample_generator(schema, options);
+    ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::RecordBatch> sample,
+                          sample_generator.Generate(kSampleRows));
+    int64_t row_bytes =
+        std::max<int64_t>(1, arrow::util::TotalBufferSize(*sample) / kSampleRows);
+    int64_t rows_per_batch = std::max<int64_t>(1, target_batch_bytes / row_bytes);
+
+    // Use a different seed than the sample so the stream does not start with it
+    options.seed = FastRandom(options.seed).Next();
+    std::shared_ptr<RandomBatchReader> reader(new RandomBatchReader(
+        schema, options, rows_per_batch, max_rows_per_second, max_rows));
+    reader->GenerateAhead();
+    return reader;
+  }
+
+  std::shared_ptr<arrow::Schema> schema() const override { return schema_; }
+
+  /// \brief Wait for the next batch, which is null at the end of the stream
+  ///
+  /// The batch is generated on the CPU thread pool, so this must not be called from
+  /// one of its threads.
+  arrow::Status ReadNext(std::shared_ptr<arrow::RecordBatch>* batch) override {
+    if (!next_batch_.is_valid()) {
+      *batch = nullptr;
+      return arrow::Status::OK();
+    }
+    if (arrow::internal::GetCpuThreadPool()->OwnsThisThread()) {
+      return arrow::Status::Invalid("Cannot wait for a batch on the CPU thread pool");
+    }
+    ARROW_ASSIGN_OR_RAISE(*batch, next_batch_.result());
+    GenerateAhead();
+
+    if (max_rows_per_second_ > 0) {
+      // Wait until the rows already read are due, so the first batch comes at once
+      if (rows_read_ == 0) start_ = std::chrono::steady_clock::now();
+      std::this_thread::sleep_until(
+          start_ + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                       std::chrono::duration<double>(rows_read_ / max_rows_per_second_)));
+    }
+    rows_read_ += (*batch)->num_rows();
+    return arrow::Status::OK();
+  }
+
+  int64_t rows_per_batch() const { return rows_per_batch_; }
+
+ private:
+  RandomBatchReader(std::shared_ptr<arrow::Schema> schema, RandomDataOptions options,
+                    int64_t rows_per_batch, double max_rows_per_second,
+                    int64_t max_rows)
+      : schema_(schema),
+        generator_(schema, options),
+        rows_per_batch_(rows_per_batch),
+        max_rows_per_second_(max_rows_per_second),
+        max_rows_(max_rows) {}
+
+  /// \brief Start generating the next batch, unless every row has been generated
+  void GenerateAhead() {
+    int64_t num_rows = rows_per_batch_;
+    if (max_rows_ >= 0) num_rows = std::min(num_rows, max_rows_ - rows_generated_);
+    if (num_rows <= 0) {
+      next_batch_ = {};
+      return;
+    }
+    // The columns are generated on the CPU thread pool and the batch is assembled
+    // when the last one is done, so no thread waits for them in the meantime
+    next_batch_ = generator_.GenerateAsync(num_rows);
+    rows_generated_ += num_rows;
+  }
+
+  std::shared_ptr<arrow::Schema> schema_;
+  BulkRandomBatchGenerator generator_;
+  int64_t rows_per_batch_;
+  double max_rows_per_second_;
+  int64_t max_rows_;
+  int64_t rows_generated_ = 0;
+  int64_t rows_read_ = 0;
+  std::chrono::steady_clock::time_point start_;
+  arrow::Future<std::shared_ptr<arrow::RecordBatch>> next_batch_;
+};  // RandomBatchReader
+
+/// \brief The same stream as an asynchronous generator, e.g. to feed an exec plan
+///
+/// ReadNext waits for the CPU thread pool, so it is called from `io_executor`, the
+/// IO thread pool by default.
+arrow::Result<arrow::AsyncGenerator<std::shared_ptr<arrow::RecordBatch>>>
+MakeRandomBatchGenerator(
+    std::shared_ptr<RandomBatchReader> reader,
+    arrow::internal::Executor* io_executor = arrow::io::default_io_context().executor()) {
+  return arrow::MakeBackgroundGenerator(arrow::MakeIteratorFromReader(reader),
+                                        io_executor);
+}
+
+arrow::Result<arrow::AsyncGenerator<std::shared_ptr<arrow::RecordBatch>>>
+MakeRandomBatchStream(std::shared_ptr<arrow::Schema> schema, int64_t target_batch_bytes) {
+  ARROW_ASSIGN_OR_RAISE(
+      std::shared_ptr<RandomBatchReader> reader,
+      RandomBatchReader::Make(std::move(schema), RandomDataOptions(),
+                              target_batch_bytes));
+  return MakeRandomBatchGenerator(std::move(reader));
+}
+
+arrow::Status StreamRandomData() {
+  StartRecipe("StreamRandomData");
+  std::shared_ptr<arrow::Schema> schema = arrow::schema({
+      arrow::field("customer", arrow::int64(), /*nullable=*/false),
+      arrow::field("amount", arrow::float64()),
+  });
+  RandomDataOptions options;
+  options.distribution = RandomDataOptions::Distribution::kZipf;
+  options.cardinality = 1000;
+  options.zipf_exponent = 1.2;
+  // Batches of about 1MiB, at most 20 of them
+  ARROW_ASSIGN_OR_RAISE(
+      std::shared_ptr<RandomBatchReader> reader,
+      RandomBatchReader::Make(schema, options, /*target_batch_bytes=*/1 << 20,
+                              /*max_rows_per_second=*/0,
+                              /*max_rows=*/20 * ((1 << 20) / 16)));
+  rout << "Batches have " << reader->rows_per_batch() << " rows" << std::endl;
+
+  std::unordered_map<int64_t, int64_t> customer_counts;
+  int64_t num_rows = 0;
+  for (arrow::Result<std::shared_ptr<arrow::RecordBatch>> maybe_batch : *reader) {
+    ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::RecordBatch> batch, maybe_batch);
+    std::shared_ptr<arrow::Int64Array> customers =
+        std::static_pointer_cast<arrow::Int64Array>(batch->column(0));
+    for (int64_t i = 0; i < customers->length(); i++) {
+      customer_counts[customers->Value(i)]++;
+    }
+    num_rows += batch->num_rows();
+  }
+  rout << "Read " << num_rows << " rows" << std::endl;
+  rout << customer_counts.size() << " distinct customers, the most active customer has "
+       << customer_counts[0] << " rows" << std::endl;
+  EndRecipe("StreamRandomData");
+
+  // With a uniform distribution every customer would have about 1300 rows
+  EXPECT_GT(customer_counts[0], 10 * num_rows / 1000);
+
+  // The generator ends with the reader, after the last of its rows.  Reading ahead
+  // must not need a second IO thread while the first waits for a batch.
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::internal::ThreadPool> one_io_thread,
+                        arrow::internal::ThreadPool::Make(1));
+  ARROW_ASSIGN_OR_RAISE(
+      std::shared_ptr<RandomBatchReader> short_reader,
+      RandomBatchReader::Make(schema, RandomDataOptions(), /*target_batch_bytes=*/16000,
+                              /*max_rows_per_second=*/0, /*max_rows=*/2500));
+  ARROW_ASSIGN_OR_RAISE(arrow::AsyncGenerator<std::shared_ptr<arrow::RecordBatch>> gen,
+                        MakeRandomBatchGenerator(short_reader, one_io_thread.get()));
+  arrow::Future<std::vector<std::shared_ptr<arrow::RecordBatch>>> collected =
+      arrow::CollectAsyncGenerator(gen);
+  ARROW_ASSIGN_OR_RAISE(std::vector<std::shared_ptr<arrow::RecordBatch>> short_batches,
+                        collected.result());
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Table> short_table,
+                        arrow::Table::FromRecordBatches(schema, short_batches));
+  EXPECT_EQ(short_table->num_rows(), 2500);
+
+  // A rate limited stream delivers rows no faster than asked
+  ARROW_ASSIGN_OR_RAISE(
+      std::shared_ptr<RandomBatchReader> limited_reader,
+      RandomBatchReader::Make(schema, RandomDataOptions(), /*target_batch_bytes=*/16000,
+                              /*max_rows_per_second=*/10000, /*max_rows=*/5000));
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Table> limited_table,
+                        arrow::Table::FromRecordBatchReader(limited_reader.get()));
+  double seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  EXPECT_EQ(limited_table->num_rows(), 5000);
+  EXPECT_GE(seconds, 0.4);
+  return arrow::Status::OK();
+}
+
+/// \brief Ways of building a numeric array from a std::vector of values
+template <typename ArrowType>
+std::vector<BuildStyle> NumericBuildStyles(
+    const std::vector<typename ArrowType::c_type>& values,
+    const std::list<typename ArrowType::c_type>& list) {
+  using CType = typename ArrowType::c_type;
+  using BuilderType = arrow::NumericBuilder<ArrowType>;
+  return {
+      {"Append",
+       [&]() -> arrow::Result<std::shared_ptr<arrow::Array>> {
+         BuilderType builder;
+         for (CType value : values) {
+           ARROW_RETURN_NOT_OK(builder.Append(value));
+         }
+         return builder.Finish();
+       }},
+      {"Reserve + Append",
+       [&]() -> arrow::Result<std::shared_ptr<arrow::Array>> {
+         BuilderType builder;
+         ARROW_RETURN_NOT_OK(builder.Reserve(values.size()));
+         for (CType value : values) {
+           ARROW_RETURN_NOT_OK(builder.Append(value));
+         }
+         return builder.Finish();
+       }},
+      {"Reserve + UnsafeAppend",
+       [&]() -> arrow::Result<std::shared_ptr<arrow::Array>> {
+         BuilderType builder;
+         ARROW_RETURN_NOT_OK(builder.Reserve(values.size()));
+         for (CType value : values) {
+           builder.UnsafeAppend(value);
+         }
+         return builder.Finish();
+       }},
+      {"AppendValues(pointer)",
+       [&]() -> arrow::Result<std::shared_ptr<arrow::Array>> {
+         BuilderType builder;
+         ARROW_RETURN_NOT_OK(builder.AppendValues(values.data(), values.size()));
+         return builder.Finish();
+       }},
+      {"AppendValues(list iterators)",
+       [&]() -> arrow::Result<std::shared_ptr<arrow::Array>> {
+         BuilderType builder;
+         ARROW_RETURN_NOT_OK(builder.AppendValues(list.begin(), list.end()));
+         return builder.Finish();
+       }},
+      {"ArrayData::Make",
+       [&]() -> arrow::Result<std::shared_ptr<arrow::Array>> {
+         // Copy the vector to stand in for data that is already owned by the caller,
+         // then hand the copy to Arrow without copying again
+         std::shared_ptr<arrow::Buffer> buffer =
+             arrow::Buffer::FromVector(std::vector<CType>(values));
+         return arrow::MakeArray(arrow::ArrayData::Make(
+             arrow::TypeTraits<ArrowType>::type_singleton(),
+             static_cast<int64_t>(values.size()), {nullptr, std::move(buffer)}));
+       }},
+  };
+}
+
+/// \brief Ways of building a string array from a std::vector of strings
+std::vector<BuildStyle> StringBuildStyles(const std::vector<std::string>& values,
+                                          int64_t data_length) {
+  return {
+      {"Append",
+       [&values, data_length]() -> arrow::Result<std::shared_ptr<arrow::Array>> {
+         arrow::StringBuilder builder;
+         for (const std::string& value : values) {
+           ARROW_RETURN_NOT_OK(builder.Append(value));
+         }
+         return builder.Finish();
+       }},
+      {"Reserve + Append",
+       [&values, data_length]() -> arrow::Result<std::shared_ptr<arrow::Array>> {
+         arrow::StringBuilder builder;
+         ARROW_RETURN_NOT_OK(builder.Reserve(values.size()));
+         for (const std::string& value : values) {
+           ARROW_RETURN_NOT_OK(builder.Append(value));
+         }
+         return builder.Finish();
+       }},
+      {"Reserve + ReserveData + Append",
+       [&values, data_length]() -> arrow::Result<std::shared_ptr<arrow::Array>> {
+         arrow::StringBuilder builder;
+         ARROW_RETURN_NOT_OK(builder.Reserve(values.size()));
+         ARROW_RETURN_NOT_OK(builder.ReserveData(data_length));
+         for (const std::string& value : values) {
+           ARROW_RETURN_NOT_OK(builder.Append(value));
+         }
+         return builder.Finish();
+       }},
+      {"Reserve + ReserveData + UnsafeAppend",
+       [&values, data_length]() -> arrow::Result<std::shared_ptr<arrow::Array>> {
+         arrow::StringBuilder builder;
+         ARROW_RETURN_NOT_OK(builder.Reserve(values.size()));
+         ARROW_RETURN_NOT_OK(builder.ReserveData(data_length));
+         for (const std::string& value : values) {
+           builder.UnsafeAppend(value);
+         }
+         return builder.Finish();
+       }},
+      {"AppendValues(vector)",
+       [&values, data_length]() -> arrow::Result<std::shared_ptr<arrow::Array>> {
+         arrow::StringBuilder builder;
+         ARROW_RETURN_NOT_OK(builder.AppendValues(values));
+         return builder.Finish();
+       }},
+      {"ArrayData::Make",
+       [&values, data_length]() -> arrow::Result<std::shared_ptr<arrow::Array>> {
+         // Lay out the offsets and characters ourselves and wrap them
+         std::vector<int32_t> offsets = {0};
+         std::string data;
+         data.reserve(data_length);
+         for (const std::string& value : values) {
+           data += value;
+           offsets.push_back(static_cast<int32_t>(data.size()));
+         }
+         return arrow::MakeArray(arrow::ArrayData::Make(
+             arrow::utf8(), static_cast<int64_t>(values.size()),
+             {nullptr, arrow::Buffer::FromVector(std::move(offsets)),
+              arrow::Buffer::FromString(std::move(data))}));
+       }},
+  };
+}
+
+template std::vector<BuildStyle> NumericBuildStyles<arrow::Int32Type>(
+    const std::vector<int32_t>& values, const std::list<int32_t>& list);
+template std::vector<BuildStyle> NumericBuildStyles<arrow::Int64Type>(
+    const std::vector<int64_t>& values, const std::list<int64_t>& list);
+template std::vector<BuildStyle> NumericBuildStyles<arrow::DoubleType>(
+    const std::vector<double>& values, const std::list<double>& list);
+
+/// \brief Build the same array with every style and check that the results agree
+arrow::Status CheckBuildStyles(const std::string& type_name,
+                               const std::vector<BuildStyle>& styles) {
+  std::shared_ptr<arrow::Array> expected;
+  for (const BuildStyle& style : styles) {
+    ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Array> array, style.build());
+    if (expected == nullptr) {
+      expected = array;
+    } else if (!array->Equals(*expected)) {
+      return arrow::Status::Invalid(style.name, " built a different ", type_name,
+                                    " array");
+    }
+  }
+  rout << "All " << styles.size() << " styles built " << expected->ToString()
+       << std::endl;
+  return arrow::Status::OK();
+}
+
+arrow::Status CompareBuildStyles() {
+  StartRecipe("ComparingBuildStyles");
+  std::vector<int64_t> int64_values = {1, 2, 3, 4};
+  std::list<int64_t> int64_list(int64_values.begin(), int64_values.end());
+  ARROW_RETURN_NOT_OK(CheckBuildStyles(
+      "int64", NumericBuildStyles<arrow::Int64Type>(int64_values, int64_list)));
+  std::vector<std::string> string_values = {"one", "two", "three"};
+  ARROW_RETURN_NOT_OK(
+      CheckBuildStyles("string", StringBuildStyles(string_values, /*data_length=*/11)));
+  EndRecipe("ComparingBuildStyles");
+  return arrow::Status::OK();
+}
+
+/// \brief A memory pool for short-lived allocations that are freed together
+///
+/// Small allocations are carved out of large blocks by bumping a pointer, which is
+/// much cheaper than a general purpose allocator.  Freeing an allocation does not
+/// return its memory to the block, but once everything allocated from the blocks
+/// has been freed they are reused from the start.  This suits building a batch and
+/// throwing it away before building the next one.  Allocations larger than
+/// `max_arena_allocation`, or aligned to more than 64 bytes, go straight to the
+/// upstream pool.
+class ArenaMemoryPool : public arrow::MemoryPool {
+ public:
+  explicit ArenaMemoryPool(arrow::MemoryPool* upstream = arrow::default_memory_pool(),
+                           int64_t block_size = 1 << 20,
+                           int64_t max_arena_allocation = 1 << 18)
+      : upstream_(upstream),
+        block_size_(block_size),
+        max_arena_allocation_(std::min(block_size, max_arena_allocation)) {}
+
+  ~ArenaMemoryPool() override {
+    for (uint8_t* block : blocks_) {
+      upstream_->Free(block, block_size_, kAlignment);
+    }
+  }
+
+  arrow::Status Allocate(int64_t size, int64_t alignment, uint8_t** out) override {
+    if (!InArena(size, alignment)) {
+      ARROW_RETURN_NOT_OK(upstream_->Allocate(size, alignment, out));
+      std::lock_guard<std::mutex> lock(mutex_);
+      UpdateStats(size);
+    } else {
+      std::lock_guard<std::mutex> lock(mutex_);
+      ARROW_RETURN_NOT_OK(AllocateFromArena(size, out));
+      UpdateStats(size);
+    }
+    return arrow::Status::OK();
+  }
+
+  arrow::Status Reallocate(int64_t old_size, int64_t new_size, int64_t alignment,
+                           uint8_t** ptr) override {
+    if (!InArena(old_size, alignment) && !InArena(new_size, alignment)) {
+      ARROW_RETURN_NOT_OK(upstream_->Reallocate(old_size, new_size, alignment, ptr));
+      std::lock_guard<std::mutex> lock(mutex_);
+      UpdateStats(new_size - old_size);
+      return arrow::Status::OK();
+    }
+    if (InArena(old_size, alignment) && InArena(new_size, alignment)) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      // Shrink in place, or grow in place if this is the latest allocation and the
+      // block has room.  Builders grow their latest buffer over and over, so this is
+      // the common case.  The allocation may be in an earlier block, so addresses are
+      // compared as integers rather than subtracted as pointers.
+      uintptr_t block = reinterpret_cast<uintptr_t>(blocks_[current_block_]);
+      uintptr_t address = reinterpret_cast<uintptr_t>(*ptr);
+      bool is_latest = address >= block && address + static_cast<uintptr_t>(old_size) ==
+                                               block + static_cast<uintptr_t>(used_);
+      int64_t new_used = used_ - old_size + new_size;
+      if (new_size <= old_size || (is_latest && new_used <= block_size_)) {
+        if (is_latest) used_ = new_used;
+        arena_bytes_ += new_size - old_size;
+        UpdateStats(new_size - old_size);
+        return arrow::Status::OK();
+      }
+    }
+    // Move between the arena and the upstream pool, or to a new place in the arena
+    uint8_t* new_ptr;
+    ARROW_RETURN_NOT_OK(Allocate(new_size, alignment, &new_ptr));
+    std::memcpy(new_ptr, *ptr, static_cast<size_t>(std::min(old_size, new_size)));
+    Free(*ptr, old_size, alignment);
+    *ptr = new_ptr;
+    return arrow::Status::OK();
+  }
+
+  void Free(uint8_t* buffer, int64_t size, int64_t alignment) override {
+    if (!InArena(size, alignment)) upstream_->Free(buffer, size, alignment);
+    std::lock_guard<std::mutex> lock(mutex_);
+    bytes_allocated_ -= size;
+    if (InArena(size, alignment)) {
+      arena_bytes_ -= size;
+      if (arena_bytes_ == 0) {
+        // Nothing in the arena is in use any more, start over from the first block
+        current_block_ = 0;
+        used_ = 0;
+      }
+    }
+  }
+
+  /// \brief Give back every block that is not in use to the upstream pool
+  void ReleaseUnused() override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    while (blocks_.size() > current_block_ + 1) {
+      upstream_->Free(blocks_.back(), block_size_, kAlignment);
+      blocks_.pop_back();
+    }
+    upstream_->ReleaseUnused();
+  }
+
+  int64_t bytes_allocated() const override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return bytes_allocated_;
+  }
+
+  int64_t max_memory() const override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return max_memory_;
+  }
+
+  int64_t total_bytes_allocated() const override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return total_bytes_allocated_;
+  }
+
+  int64_t num_allocations() const override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return num_allocations_;
+  }
+
+  std::string backend_name() const override {
+    return "arena(" + upstream_->backend_name() + ")";
+  }
+
+ private:
+  // Enough for any SIMD instruction and the same as Arrow's default alignment
+  static constexpr int64_t kAlignment = 64;
+
+  /// \brief Whether an allocation comes from the arena or from the upstream pool
+  ///
+  /// Blocks are only aligned to kAlignment, so larger alignments go upstream too.
+  bool InArena(int64_t size, int64_t alignment) const {
+    return size <= max_arena_allocation_ && alignment <= kAlignment;
+  }
+
+  arrow::Status AllocateFromArena(int64_t size, uint8_t** out) {
+    int64_t offset = 0;
+    if (!blocks_.empty()) {
+      offset = arrow::bit_util::RoundUp(used_, kAlignment);
+    }
+    if (blocks_.empty() || offset + size > block_size_) {
+      // Move on to the next block, reusing one from before if there is one
+      if (!blocks_.empty()) current_block_++;
+      if (current_block_ == blocks_.size()) {
+        uint8_t* block;
+        ARROW_RETURN_NOT_OK(upstream_->Allocate(block_size_, kAlignment, &block));
+        blocks_.push_back(block);
+      }
+      offset = 0;
+    }
+    *out = blocks_[current_block_] + offset;
+    used_ = offset + size;
+    arena_bytes_ += size;
+    return arrow::Status::OK();
+  }
+
+  // Must be called with mutex_ held
+  void UpdateStats(int64_t size_change) {
+    bytes_allocated_ += size_change;
+    max_memory_ = std::max(max_memory_, bytes_allocated_);
+    if (size_change > 0) total_bytes_allocated_ += size_change;
+    num_allocations_++;
+  }
+
+  arrow::MemoryPool* upstream_;
+  const int64_t block_size_;
+  const int64_t max_arena_allocation_;
+
+  mutable std::mutex mutex_;
+  std::vector<uint8_t*> blocks_;
+  size_t current_block_ = 0;
+  // Bytes used in the current block
+  int64_t used_ = 0;
+  // Bytes allocated from the arena that have not been freed yet
+  int64_t arena_bytes_ = 0;
+  int64_t bytes_allocated_ = 0;
+  int64_t max_memory_ = 0;
+  int64_t total_bytes_allocated_ = 0;
+  int64_t num_allocations_ = 0;
+};  // ArenaMemoryPool
+
+/// \brief Build a batch of many small columns, as when converting a few rows
+arrow::Result<std::shared_ptr<arrow::RecordBatch>> BuildSmallBatch(
+    arrow::MemoryPool* pool) {
+  constexpr int kNumColumns = 16;
+  constexpr int64_t kNumRows = 256;
+  std::vector<std::shared_ptr<arrow::Field>> fields;
+  std::vector<std::shared_ptr<arrow::Array>> columns;
+  for (int column = 0; column < kNumColumns; column++) {
+    std::shared_ptr<arrow::Array> array;
+    if (column % 2 == 0) {
+      arrow::Int64Builder builder(pool);
+      for (int64_t row = 0; row < kNumRows; row++) {
+        ARROW_RETURN_NOT_OK(builder.Append(row * column));
+      }
+      ARROW_RETURN_NOT_OK(builder.Finish(&array));
+    } else {
+      arrow::StringBuilder builder(pool);
+      for (int64_t row = 0; row < kNumRows; row++) {
+        std::string value = "row-";
+        value += std::to_string(row);
+        ARROW_RETURN_NOT_OK(builder.Append(value));
+      }
+      ARROW_RETURN_NOT_OK(builder.Finish(&array));
+    }
+    std::string name = "c";
+    name += std::to_string(column);
+    fields.push_back(arrow::field(std::move(name), array->type()));
+    columns.push_back(std::move(array));
+  }
+  return arrow::RecordBatch::Make(arrow::schema(std::move(fields)), kNumRows,
+                                  std::move(columns));
+}
+
+arrow::Status CompareMemoryPools() {
+  StartRecipe("UsingAnArenaMemoryPool");
+  // A proxy pool counts how often the arena goes to the system allocator
+  arrow::ProxyMemoryPool upstream(arrow::system_memory_pool());
+  ArenaMemoryPool arena(&upstream);
+  for (int i = 0; i < 100; i++) {
+    ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::RecordBatch> batch,
+                          BuildSmallBatch(&arena));
+    ARROW_RETURN_NOT_OK(batch->ValidateFull());
+  }
+  rout << "Built 100 batches with " << arena.num_allocations()
+       << " allocations and reallocations" << std::endl;
+  rout << "The arena allocated " << upstream.num_allocations()
+       << " blocks from the system allocator" << std::endl;
+  rout << "Memory still in use: " << arena.bytes_allocated() << " bytes" << std::endl;
+  EndRecipe("UsingAnArenaMemoryPool");
+  EXPECT_EQ(arena.bytes_allocated(), 0);
+
+  return arrow::Status::OK();
+}
+
+std::unique_ptr<arrow::MemoryPool> MakeArenaMemoryPool(arrow::MemoryPool* upstream) {
+  return std::make_unique<ArenaMemoryPool>(upstream);
+}
+
 TEST(CreatingArrowObjects, CreatingArraysTest) { ASSERT_OK(CreatingArrays()); }
 TEST(CreatingArrowObjects, CreatingArraysPtrTest) { ASSERT_OK(CreatingArraysPtr()); }
 TEST(CreatingArrowObjects, GeneratingRandomData) { ASSERT_OK(GenerateRandomData()); }
+TEST(CreatingArrowObjects, GeneratingRandomDataInBulk) {
+  ASSERT_OK(GenerateRandomDataInBulk());
+}
+TEST(CreatingArrowObjects, StreamingRandomData) { ASSERT_OK(StreamRandomData()); }
+TEST(CreatingArrowObjects, ComparingBuildStyles) { ASSERT_OK(CompareBuildStyles()); }
+TEST(CreatingArrowObjects, UsingAnArenaMemoryPool) { ASSERT_OK(CompareMemoryPools()); }
+
+TEST(CreatingArrowObjects, ArenaMemoryPoolAllocations) {
+  arrow::ProxyMemoryPool upstream(arrow::system_memory_pool());
+  ArenaMemoryPool arena(&upstream, /*block_size=*/4096, /*max_arena_allocation=*/1024);
+  uint8_t* small;
+  ASSERT_OK(arena.Allocate(10, 8, &small));
+  uint8_t* empty;
+  ASSERT_OK(arena.Allocate(0, 8, &empty));
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(small) % 64, 0);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(empty) % 64, 0);
+  // Growing the latest allocation does not move it
+  ASSERT_OK(arena.Reallocate(0, 100, 8, &empty));
+  EXPECT_EQ(upstream.num_allocations(), 1);
+  // Growing past the limit moves it to the upstream pool
+  std::memset(empty, 7, 100);
+  ASSERT_OK(arena.Reallocate(100, 2000, 8, &empty));
+  EXPECT_EQ(empty[99], 7);
+  EXPECT_EQ(upstream.num_allocations(), 2);
+  EXPECT_EQ(arena.bytes_allocated(), 2010);
+  arena.Free(empty, 2000, 8);
+  arena.Free(small, 10, 8);
+  EXPECT_EQ(arena.bytes_allocated(), 0);
+  // Both copies were alive while moving to the upstream pool
+  EXPECT_EQ(arena.max_memory(), 2110);
+
+  // Alignments the blocks cannot promise come from the upstream pool
+  uint8_t* aligned;
+  ASSERT_OK(arena.Allocate(10, 256, &aligned));
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(aligned) % 256, 0);
+  EXPECT_EQ(upstream.num_allocations(), 3);
+  arena.Free(aligned, 10, 256);
+
+  // An allocation left behind in an earlier block is moved rather than grown
+  uint8_t* first;
+  ASSERT_OK(arena.Allocate(1000, 8, &first));
+  std::memset(first, 3, 1000);
+  uint8_t* filler[4];
+  for (uint8_t*& ptr : filler) ASSERT_OK(arena.Allocate(1000, 8, &ptr));
+  uint8_t* before = first;
+  ASSERT_OK(arena.Reallocate(1000, 1020, 8, &first));
+  EXPECT_NE(first, before);
+  EXPECT_EQ(first[999], 3);
+  for (uint8_t* ptr : filler) arena.Free(ptr, 1000, 8);
+  arena.Free(first, 1020, 8);
+  EXPECT_EQ(arena.bytes_allocated(), 0);
+}
@@ -0,0 +1,79 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef ARROW_COOKBOOK_CREATING_ARROW_OBJECTS_H
+#define ARROW_COOKBOOK_CREATING_ARROW_OBJECTS_H
+
+// Code from creating_arrow_objects.cc that creating_arrow_objects_benchmark.cc
+// measures
+
+#include <arrow/api.h>
+#include <arrow/util/async_generator_fwd.h>
+#include <arrow/util/future.h>
+
+#include <functional>
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+
+/// \brief A named way of building an array from data that already exists
+struct BuildStyle {
+  std::string name;
+  std::function<arrow::Result<std::shared_ptr<arrow::Array>>()> build;
+};
+
+/// \brief Ways of building a numeric array from a std::vector of values
+///
+/// Defined for Int32Type, Int64Type and DoubleType.  The styles refer to `values`
+/// and `list`, which must outlive them.
+template <typename ArrowType>
+std::vector<BuildStyle> NumericBuildStyles(
+    const std::vector<typename ArrowType::c_type>& values,
+    const std::list<typename ArrowType::c_type>& list);
+
+/// \brief Ways of building a string array from a std::vector of strings
+///
+/// `data_length` is the total length of the strings.  The styles refer to `values`,
+/// which must outlive them.
+std::vector<BuildStyle> StringBuildStyles(const std::vector<std::string>& values,
+                                          int64_t data_length);
+
+/// \brief Generate `num_rows` random rows of `schema` by appending one value at a time
+///
+/// Only double and list columns are supported.
+arrow::Result<std::shared_ptr<arrow::RecordBatch>> GenerateRandomRowsByAppending(
+    std::shared_ptr<arrow::Schema> schema, int32_t num_rows);
+
+/// \brief Generate `num_rows` random rows of `schema` a buffer at a time, one column
+/// per task on the CPU thread pool
+arrow::Result<std::shared_ptr<arrow::RecordBatch>> GenerateRandomRowsInBulk(
+    std::shared_ptr<arrow::Schema> schema, int64_t num_rows);
+
+/// \brief An endless stream of random batches of `schema` of about
+/// `target_batch_bytes` each, the next one generated while the current one is used
+arrow::Result<arrow::AsyncGenerator<std::shared_ptr<arrow::RecordBatch>>>
+MakeRandomBatchStream(std::shared_ptr<arrow::Schema> schema, int64_t target_batch_bytes);
+
+/// \brief Build a batch of 16 short columns, half of them strings, from `pool`
+arrow::Result<std::shared_ptr<arrow::RecordBatch>> BuildSmallBatch(
+    arrow::MemoryPool* pool);
+
+/// \brief An arena of 1MiB blocks that allocates from `upstream`, which must outlive it
+std::unique_ptr<arrow::MemoryPool> MakeArenaMemoryPool(arrow::MemoryPool* upstream);
+
+#endif  // ARROW_COOKBOOK_CREATING_ARROW_OBJECTS_H
@@ -0,0 +1,243 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <benchmark/benchmark.h>
+
+#include <arrow/api.h>
+#include <arrow/io/api.h>
+#include <arrow/util/byte_size.h>
+#include <parquet/arrow/reader.h>
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "benchmark_common.h"
+#include "common.h"
+#include "creating_arrow_objects.h"
+
+// Benchmarks for the recipes in creating_arrow_objects.cc
+
+namespace {
+
+/// \brief The values every build style of `ArrowType` is given
+template <typename ArrowType>
+std::vector<typename ArrowType::c_type> MakeNumericValues(int64_t length) {
+  std::vector<typename ArrowType::c_type> values(static_cast<size_t>(length));
+  for (int64_t i = 0; i < length; i++) {
+    values[i] = static_cast<typename ArrowType::c_type>(i) / 2;
+  }
+  return values;
+}
+
+/// \brief Run one build style and report the rows and bytes it built per second
+void RunBuildStyle(benchmark::State& state, const BuildStyle& style) {
+  int64_t array_bytes = 0;
+  for (auto _ : state) {
+    arrow::Result<std::shared_ptr<arrow::Array>> array = style.build();
+    if (!array.ok()) {
+      state.SkipWithError(array.status().ToString().c_str());
+      return;
+    }
+    array_bytes = arrow::util::TotalBufferSize(**array);
+    benchmark::DoNotOptimize(*array);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.SetBytesProcessed(state.iterations() * array_bytes);
+}
+
+template <typename ArrowType>
+void BuildNumericArray(benchmark::State& state, size_t style_index) {
+  std::vector<typename ArrowType::c_type> values =
+      MakeNumericValues<ArrowType>(state.range(0));
+  std::list<typename ArrowType::c_type> list(values.begin(), values.end());
+  RunBuildStyle(state, NumericBuildStyles<ArrowType>(values, list)[style_index]);
+}
+
+void BuildStringArray(benchmark::State& state, size_t style_index) {
+  std::vector<std::string> values(static_cast<size_t>(state.range(0)));
+  int64_t data_length = 0;
+  for (size_t i = 0; i < values.size(); i++) {
+    values[i] = "value-" + std::to_string(i);
+    data_length += static_cast<int64_t>(values[i].size());
+  }
+  RunBuildStyle(state, StringBuildStyles(values, data_length)[style_index]);
+}
+
+/// \brief Register one benchmark per style, named BuildArray<type>/<style>
+template <typename Function>
+void RegisterBuildStyles(const std::string& type_name,
+                         const std::vector<BuildStyle>& styles, Function function) {
+  for (size_t i = 0; i < styles.size(); i++) {
+    std::string name = "BuildArray<" + type_name + ">/" + styles[i].name;
+    benchmark::RegisterBenchmark(name.c_str(), function, i)
+        ->ArgName("length")
+        ->RangeMultiplier(32)
+        ->Range(1 << 10, 1 << 20);
+  }
+}
+
+template <typename ArrowType>
+void RegisterNumericBuildStyles(const std::string& type_name) {
+  // The styles are only asked for their names here, so they can build nothing
+  std::vector<typename ArrowType::c_type> no_values;
+  std::list<typename ArrowType::c_type> no_list;
+  RegisterBuildStyles(type_name, NumericBuildStyles<ArrowType>(no_values, no_list),
+                      BuildNumericArray<ArrowType>);
+}
+
+int RegisterAllBuildStyles() {
+  RegisterNumericBuildStyles<arrow::Int32Type>("int32");
+  RegisterNumericBuildStyles<arrow::Int64Type>("int64");
+  RegisterNumericBuildStyles<arrow::DoubleType>("double");
+  std::vector<std::string> no_values;
+  RegisterBuildStyles("string", StringBuildStyles(no_values, 0), BuildStringArray);
+  return 0;
+}
+
+[[maybe_unused]] const int kBuildStylesRegistered = RegisterAllBuildStyles();
+
+/// \brief Generate a batch of random doubles and lists of doubles by appending values
+/// one at a time, or a buffer at a time with one column per task
+arrow::Status GenerateRandomRows(benchmark::State& state, bool bulk) {
+  std::shared_ptr<arrow::Schema> schema =
+      arrow::schema({arrow::field("x", arrow::float64()),
+                     arrow::field("y", arrow::list(arrow::float64()))});
+  int32_t num_rows = static_cast<int32_t>(state.range(0));
+  for (auto _ : state) {
+    std::shared_ptr<arrow::RecordBatch> batch;
+    if (bulk) {
+      ARROW_ASSIGN_OR_RAISE(batch, GenerateRandomRowsInBulk(schema, num_rows));
+    } else {
+      ARROW_ASSIGN_OR_RAISE(batch, GenerateRandomRowsByAppending(schema, num_rows));
+    }
+    benchmark::DoNotOptimize(batch);
+  }
+  state.SetItemsProcessed(state.iterations() * num_rows);
+  return arrow::Status::OK();
+}
+
+/// \brief Consume an endless stream of random batches of 1MiB as fast as it comes
+arrow::Status StreamRandomBatches(benchmark::State& state) {
+  std::shared_ptr<arrow::Schema> schema = arrow::schema({
+      arrow::field("customer", arrow::int64(), /*nullable=*/false),
+      arrow::field("amount", arrow::float64()),
+  });
+  ARROW_ASSIGN_OR_RAISE(arrow::AsyncGenerator<std::shared_ptr<arrow::RecordBatch>> gen,
+                        MakeRandomBatchStream(schema, /*target_batch_bytes=*/1 << 20));
+  int64_t num_bytes = 0;
+  for (auto _ : state) {
+    arrow::Future<std::shared_ptr<arrow::RecordBatch>> next_batch = gen();
+    ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::RecordBatch> batch, next_batch.result());
+    num_bytes += arrow::util::TotalBufferSize(*batch);
+  }
+  state.SetBytesProcessed(num_bytes);
+  return arrow::Status::OK();
+}
+
+int RegisterRandomDataBenchmarks() {
+  // The bulk generator works on the CPU thread pool, so only wall time compares
+  RegisterArrowBenchmark("GenerateRandomRows/append", GenerateRandomRows, false)
+      ->Arg(1 << 20)
+      ->UseRealTime()
+      ->Unit(benchmark::kMillisecond);
+  RegisterArrowBenchmark("GenerateRandomRows/bulk", GenerateRandomRows, true)
+      ->Arg(1 << 20)
+      ->UseRealTime()
+      ->Unit(benchmark::kMillisecond);
+  RegisterArrowBenchmark("StreamRandomBatches", StreamRandomBatches)->UseRealTime();
+  return 0;
+}
+
+[[maybe_unused]] const int kRandomDataRegistered = RegisterRandomDataBenchmarks();
+
+/// \brief Build small batches one after the other from `pool`, or from an arena on
+/// top of the system allocator if `pool` is null
+arrow::Status BuildSmallBatches(benchmark::State& state, arrow::MemoryPool* pool) {
+  std::unique_ptr<arrow::MemoryPool> arena;
+  if (pool == nullptr) {
+    arena = MakeArenaMemoryPool(arrow::system_memory_pool());
+    pool = arena.get();
+  }
+  for (auto _ : state) {
+    ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::RecordBatch> batch,
+                          BuildSmallBatch(pool));
+    benchmark::DoNotOptimize(batch);
+  }
+  state.SetItemsProcessed(state.iterations());
+  return arrow::Status::OK();
+}
+
+int RegisterMemoryPoolBenchmarks() {
+  RegisterArrowBenchmark("BuildSmallBatches/system", BuildSmallBatches,
+                         arrow::system_memory_pool());
+  RegisterArrowBenchmark("BuildSmallBatches/arena", BuildSmallBatches,
+                         static_cast<arrow::MemoryPool*>(nullptr));
+  // Whichever of these Arrow was built with
+  arrow::MemoryPool* jemalloc_pool;
+  if (arrow::jemalloc_memory_pool(&jemalloc_pool).ok()) {
+    RegisterArrowBenchmark("BuildSmallBatches/jemalloc", BuildSmallBatches,
+                           jemalloc_pool);
+  }
+  arrow::MemoryPool* mimalloc_pool;
+  if (arrow::mimalloc_memory_pool(&mimalloc_pool).ok()) {
+    RegisterArrowBenchmark("BuildSmallBatches/mimalloc", BuildSmallBatches,
+                           mimalloc_pool);
+  }
+  return 0;
+}
+
+[[maybe_unused]] const int kMemoryPoolsRegistered = RegisterMemoryPoolBenchmarks();
+
+/// \brief Read the air quality test data into a table, with or without threads
+arrow::Status ReadAirQuality(benchmark::State& state, bool use_threads) {
+  ARROW_ASSIGN_OR_RAISE(std::string path, FindTestDataFile("airquality.parquet"));
+  parquet::ArrowReaderProperties properties;
+  properties.set_use_threads(use_threads);
+  int64_t bytes_read = 0;
+  for (auto _ : state) {
+    ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::io::RandomAccessFile> input,
+                          arrow::io::ReadableFile::Open(path));
+    parquet::arrow::FileReaderBuilder builder;
+    ARROW_RETURN_NOT_OK(builder.Open(input));
+    ARROW_ASSIGN_OR_RAISE(std::unique_ptr<parquet::arrow::FileReader> reader,
+                          builder.properties(properties)->Build());
+    std::shared_ptr<arrow::Table> table;
+#if ARROW_VERSION_MAJOR >= 24
+    ARROW_ASSIGN_OR_RAISE(table, reader->ReadTable());
+#else
+    ARROW_RETURN_NOT_OK(reader->ReadTable(&table));
+#endif
+    ARROW_ASSIGN_OR_RAISE(int64_t file_size, input->GetSize());
+    bytes_read += file_size;
+    benchmark::DoNotOptimize(table);
+  }
+  state.SetBytesProcessed(bytes_read);
+  return arrow::Status::OK();
+}
+
+int RegisterReadBenchmarks() {
+  RegisterArrowBenchmark("ReadAirQuality/use_threads:0", ReadAirQuality, false);
+  RegisterArrowBenchmark("ReadAirQuality/use_threads:1", ReadAirQuality, true);
+  return 0;
+}
+
+[[maybe_unused]] const int kReadRegistered = RegisterReadBenchmarks();
+
+}  // namespace
@@ -16,37 +16,159 @@
 // under the License.
 
 #include <arrow/api.h>
+#include <arrow/compute/api.h>
 #include <arrow/dataset/api.h>
 #include <arrow/filesystem/api.h>
+#include <arrow/ipc/api.h>
+#include <arrow/util/byte_size.h>
+#include <arrow/util/io_util.h>
 #include <gtest/gtest.h>
 #include <parquet/arrow/reader.h>
+#include <parquet/arrow/writer.h>
 
+#include <algorithm>
+#include <cstring>
 #include <filesystem>
+#include <functional>
+#include <ostream>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "arrow/compute/initialize.h"
 #include "common.h"
+#include "datasets.h"
+
+/// \brief Collect the footers of the parquet files written by a dataset write
+///
+/// The collected row groups can be saved as a single `_metadata` file next to
+/// the data.  Readers can then create the dataset from that one file instead of
+/// listing every directory and opening every file.
+class ParquetMetadataCollector {
+ public:
+  explicit ParquetMetadataCollector(std::string base_dir)
+      : base_dir_(std::move(base_dir)) {}
+
+  // Intended to be used as FileSystemDatasetWriteOptions::writer_post_finish which
+  // may be called from several threads at once
+  arrow::Status Collect(arrow::dataset::FileWriter* writer) {
+    auto* parquet_writer = dynamic_cast<arrow::dataset::ParquetFileWriter*>(writer);
+    if (parquet_writer == nullptr) {
+      return arrow::Status::Invalid("Can only collect metadata from parquet files");
+    }
+    const std::string& path = writer->destination().path;
+    if (path.compare(0, base_dir_.size(), base_dir_) != 0) {
+      return arrow::Status::Invalid("File ", path, " was not written under ", base_dir_);
+    }
+    // Paths in a _metadata file are relative to the directory containing it
+    std::string relative_path = path.substr(base_dir_.size());
+    relative_path.erase(0, relative_path.find_first_not_of('/'));
+
+    std::shared_ptr<parquet::FileMetaData> metadata =
+        parquet_writer->parquet_writer()->metadata();
+    metadata->set_file_path(relative_path);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    file_metadata_.emplace_back(std::move(relative_path), std::move(metadata));
+    return arrow::Status::OK();
+  }
+
+  arrow::Status WriteMetadataFile(arrow::fs::FileSystem* fs) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (file_metadata_.empty()) {
+      return arrow::Status::Invalid("No files were written to ", base_dir_);
+    }
+    // Files finish in an arbitrary order, sort them so the output is deterministic
+    std::sort(
+        file_metadata_.begin(), file_metadata_.end(),
+        [](const auto& left, const auto& right) { return left.first < right.first; });
+    std::shared_ptr<parquet::FileMetaData> combined = file_metadata_[0].second;
+    for (size_t i = 1; i < file_metadata_.size(); i++) {
+      combined->AppendRowGroups(*file_metadata_[i].second);
+    }
+    ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::io::OutputStream> sink,
+                          fs->OpenOutputStream(base_dir_ + "/_metadata"));
+    ARROW_RETURN_NOT_OK(parquet::arrow::WriteMetaDataFile(*combined, sink.get()));
+    file_metadata_.clear();
+    return sink->Close();
+  }
+
+ private:
+  std::string base_dir_;
+  std::mutex mutex_;
+  std::vector<std::pair<std::string, std::shared_ptr<parquet::FileMetaData>>>
+      file_metadata_;
+};  // ParquetMetadataCollector
+
+/// \brief Write options for the airquality data, partitioned by Month and Day
+arrow::Result<arrow::dataset::FileSystemDatasetWriteOptions> MakeAirQualityWriteOptions(
+    std::shared_ptr<arrow::fs::FileSystem> fs, const std::string& base_dir) {
+  std::shared_ptr<arrow::Schema> partitioning_schema = arrow::schema(
+      {arrow::field("Month", arrow::int32()), arrow::field("Day", arrow::int32())});
+  std::shared_ptr<arrow::dataset::PartitioningFactory> partitioning_factory =
+      arrow::dataset::HivePartitioning::MakeFactory();
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::dataset::Partitioning> partitioning,
+                        partitioning_factory->Finish(partitioning_schema));
+
+  std::shared_ptr<arrow::dataset::ParquetFileFormat> parquet_format =
+      std::make_shared<arrow::dataset::ParquetFileFormat>();
+
+  arrow::dataset::FileSystemDatasetWriteOptions write_options;
+  write_options.existing_data_behavior =
+      arrow::dataset::ExistingDataBehavior::kDeleteMatchingPartitions;
+  write_options.filesystem = std::move(fs);
+  write_options.partitioning = std::move(partitioning);
+  write_options.base_dir = base_dir;
+  write_options.basename_template = "chunk-{i}.parquet";
+  write_options.file_write_options = parquet_format->DefaultWriteOptions();
+  return write_options;
+}
+
+/// \brief The path of a temporary directory, without the trailing separator
+std::string TemporaryDirPath(arrow::internal::TemporaryDir* dir) {
+  std::string path = dir->path().ToString();
+  while (path.size() > 1 && path.back() == '/') {
+    path.pop_back();
+  }
+  return path;
+}
 
 class DatasetReadingTest : public ::testing::Test {
  public:
-  void SetUp() override {
-    // Initialize compute functions before the test runs
+  // The partitioned dataset is only read by the tests so it is written once, to a
+  // uniquely named directory, and shared by every test in the suite
+  static void SetUpTestSuite() {
+    // Initialize compute functions before the tests run
     ASSERT_OK(arrow::compute::Initialize());
 
-    airquality_partitioned_dir_ =
-        std::filesystem::temp_directory_path() / "cookbook_cpp_airquality";
+    ASSERT_OK_AND_ASSIGN(temp_dir_,
+                         arrow::internal::TemporaryDir::Make("cookbook_cpp_airquality_"));
+    airquality_partitioned_dir_ = TemporaryDirPath(temp_dir_.get());
     std::shared_ptr<arrow::fs::FileSystem> fs =
         std::make_shared<arrow::fs::LocalFileSystem>();
-    ASSERT_OK_AND_ASSIGN(std::shared_ptr<arrow::Table> airquality,
-                         ReadInAirQuality(fs.get()));
-    WritePartitionedAirQuality(airquality, std::move(fs));
+    ASSERT_OK_AND_ASSIGN(airquality_, ReadInAirQuality(fs.get()));
+    WritePartitionedAirQuality(airquality_, std::move(fs));
+  }
+
+  static void TearDownTestSuite() {
+    airquality_.reset();
+    // Removes the directory and everything written to it
+    temp_dir_.reset();
   }
 
   const std::string& airquality_basedir() { return airquality_partitioned_dir_; }
+  const std::shared_ptr<arrow::Table>& airquality() { return airquality_; }
 
  private:
-  void WritePartitionedAirQuality(const std::shared_ptr<arrow::Table>& airquality,
-                                  std::shared_ptr<arrow::fs::FileSystem> fs) {
+  static void WritePartitionedAirQuality(
+      const std::shared_ptr<arrow::Table>& airquality,
+      std::shared_ptr<arrow::fs::FileSystem> fs) {
     std::shared_ptr<arrow::RecordBatchReader> table_reader =
         std::make_shared<arrow::TableBatchReader>(*airquality);
 
@@ -56,27 +178,20 @@ class DatasetReadingTest : public ::testing::Test {
     ASSERT_OK_AND_ASSIGN(std::shared_ptr<arrow::dataset::Scanner> scanner,
                          scanner_builder->Finish());
 
-    std::shared_ptr<arrow::Schema> partitioning_schema = arrow::schema(
-        {arrow::field("Month", arrow::int32()), arrow::field("Day", arrow::int32())});
-    std::shared_ptr<arrow::dataset::PartitioningFactory> partitioning_factory =
-        arrow::dataset::HivePartitioning::MakeFactory();
-    ASSERT_OK_AND_ASSIGN(std::shared_ptr<arrow::dataset::Partitioning> partitioning,
-                         partitioning_factory->Finish(partitioning_schema));
-
-    std::shared_ptr<arrow::dataset::ParquetFileFormat> parquet_format =
-        std::make_shared<arrow::dataset::ParquetFileFormat>();
-
-    arrow::dataset::FileSystemDatasetWriteOptions write_options;
-    write_options.existing_data_behavior =
-        arrow::dataset::ExistingDataBehavior::kDeleteMatchingPartitions;
-    write_options.filesystem = std::move(fs);
-    write_options.partitioning = std::move(partitioning);
-    write_options.base_dir = airquality_partitioned_dir_;
-    write_options.basename_template = "chunk-{i}.parquet";
-    write_options.file_write_options = parquet_format->DefaultWriteOptions();
+    ASSERT_OK_AND_ASSIGN(
+        arrow::dataset::FileSystemDatasetWriteOptions write_options,
+        MakeAirQualityWriteOptions(fs, airquality_partitioned_dir_));
+
+    // Record the footer of every file so we can write a _metadata file alongside
+    // the data once the write has finished
+    ParquetMetadataCollector metadata_collector(airquality_partitioned_dir_);
+    write_options.writer_post_finish = [&](arrow::dataset::FileWriter* writer) {
+      return metadata_collector.Collect(writer);
+    };
 
     ASSERT_OK(
         arrow::dataset::FileSystemDataset::Write(write_options, std::move(scanner)));
+    ASSERT_OK(metadata_collector.WriteMetadataFile(fs.get()));
   }
 
   static arrow::Result<std::shared_ptr<arrow::Table>> ReadInAirQuality(
@@ -99,8 +214,63 @@ class DatasetReadingTest : public ::testing::Test {
     return table;
   }
 
-  std::string airquality_partitioned_dir_;
-};
+  inline static std::unique_ptr<arrow::internal::TemporaryDir> temp_dir_;
+  inline static std::string airquality_partitioned_dir_;
+  inline static std::shared_ptr<arrow::Table> airquality_;
+};  // DatasetReadingTest
+
+/// \brief Create a dataset from its _metadata file, if there is one
+///
+/// Falls back to discovering the files in the dataset directory otherwise
+arrow::Result<std::shared_ptr<arrow::dataset::Dataset>> OpenPartitionedDataset(
+    const std::shared_ptr<arrow::fs::FileSystem>& fs, const std::string& base_dir) {
+  // Create a file format which describes the format of the files.
+  // Here we specify we are reading parquet files.  We could pick a different format
+  // such as Arrow-IPC files or CSV files or we could customize the parquet format with
+  // additional reading & parsing options.
+  std::shared_ptr<arrow::dataset::ParquetFileFormat> format =
+      std::make_shared<arrow::dataset::ParquetFileFormat>();
+
+  // Create a partitioning factory.  A partitioning factory will be used by a dataset
+  // factory to infer the partitioning schema from the filenames.  All we need to
+  // specify is the flavor of partitioning which, in our case, is "hive".
+  //
+  // Alternatively, we could manually create a partitioning scheme from a schema.  This
+  // is typically not necessary for hive partitioning as inference works well.
+  std::shared_ptr<arrow::dataset::PartitioningFactory> partitioning_factory =
+      arrow::dataset::HivePartitioning::MakeFactory();
+
+  std::string metadata_path = base_dir + "/_metadata";
+  ARROW_ASSIGN_OR_RAISE(arrow::fs::FileInfo metadata_info,
+                        fs->GetFileInfo(metadata_path));
+  std::shared_ptr<arrow::dataset::DatasetFactory> dataset_factory;
+  if (metadata_info.IsFile()) {
+    // The _metadata file lists every file, along with its row groups and their
+    // statistics, so this only needs to read a single file
+    arrow::dataset::ParquetFactoryOptions options;
+    options.partitioning = partitioning_factory;
+    options.partition_base_dir = base_dir;
+    ARROW_ASSIGN_OR_RAISE(dataset_factory,
+                          arrow::dataset::ParquetDatasetFactory::Make(
+                              metadata_path, fs, format, std::move(options)));
+  } else {
+    // Create a file selector which describes which files are part of
+    // the dataset.  This selector performs a recursive search of a base
+    // directory which is typical with partitioned datasets.  You can also
+    // create a dataset from a list of one or more paths.
+    arrow::fs::FileSelector selector;
+    selector.base_dir = base_dir;
+    selector.recursive = true;
+    arrow::dataset::FileSystemFactoryOptions options;
+    options.partitioning = partitioning_factory;
+    ARROW_ASSIGN_OR_RAISE(dataset_factory, arrow::dataset::FileSystemDatasetFactory::Make(
+                                               fs, selector, format, std::move(options)));
+  }
+  // Create the dataset.  Without a _metadata file this will scan the dataset directory
+  // to find all the files and may scan some file metadata in order to determine the
+  // dataset schema.
+  return dataset_factory->Finish();
+}
 
 arrow::Status DatasetRead(const std::string& airquality_basedir) {
   StartRecipe("ListPartitionedDataset");
@@ -110,10 +280,8 @@ arrow::Status DatasetRead(const std::string& airquality_basedir) {
   std::shared_ptr<arrow::fs::LocalFileSystem> fs =
       std::make_shared<arrow::fs::LocalFileSystem>();
 
-  // Create a file selector which describes which files are part of
-  // the dataset.  This selector performs a recursive search of a base
-  // directory which is typical with partitioned datasets.  You can also
-  // create a dataset from a list of one or more paths.
+  // Create a file selector which performs a recursive search of a base
+  // directory, as the files of a partitioned dataset live in subdirectories
   arrow::fs::FileSelector selector;
   selector.base_dir = directory_base;
   selector.recursive = true;
@@ -124,7 +292,9 @@ arrow::Status DatasetRead(const std::string& airquality_basedir) {
                         fs->GetFileInfo(selector));
   int num_printed = 0;
   for (const auto& path : file_infos) {
-    if (path.IsFile()) {
+    // Files starting with "_" (e.g. _metadata) describe the dataset and are not
+    // part of the data
+    if (path.IsFile() && path.base_name()[0] != '_') {
       rout << path.path().substr(directory_base.size()) << std::endl;
       if (++num_printed == 10) {
         rout << "..." << std::endl;
@@ -134,34 +304,10 @@ arrow::Status DatasetRead(const std::string& airquality_basedir) {
   }
   EndRecipe("ListPartitionedDataset");
   StartRecipe("CreatingADataset");
-  // Create a file format which describes the format of the files.
-  // Here we specify we are reading parquet files.  We could pick a different format
-  // such as Arrow-IPC files or CSV files or we could customize the parquet format with
-  // additional reading & parsing options.
-  std::shared_ptr<arrow::dataset::ParquetFileFormat> format =
-      std::make_shared<arrow::dataset::ParquetFileFormat>();
-
-  // Create a partitioning factory.  A partitioning factory will be used by a dataset
-  // factory to infer the partitioning schema from the filenames.  All we need to
-  // specify is the flavor of partitioning which, in our case, is "hive".
-  //
-  // Alternatively, we could manually create a partitioning scheme from a schema.  This
-  // is typically not necessary for hive partitioning as inference works well.
-  std::shared_ptr<arrow::dataset::PartitioningFactory> partitioning_factory =
-      arrow::dataset::HivePartitioning::MakeFactory();
-
-  arrow::dataset::FileSystemFactoryOptions options;
-  options.partitioning = partitioning_factory;
-
-  // Create a dataset factory
-  ARROW_ASSIGN_OR_RAISE(
-      std::shared_ptr<arrow::dataset::DatasetFactory> dataset_factory,
-      arrow::dataset::FileSystemDatasetFactory::Make(fs, selector, format, options));
-
-  // Create the dataset, this will scan the dataset directory to find all the files
-  // and may scan some file metadata in order to determine the dataset schema.
+  // Reads the _metadata file written alongside the data if there is one, and
+  // discovers the files under the base directory otherwise
   ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::dataset::Dataset> dataset,
-                        dataset_factory->Finish());
+                        OpenPartitionedDataset(fs, directory_base));
 
   rout << "We discovered the following schema for the dataset:" << std::endl
        << std::endl
@@ -184,6 +330,1593 @@ arrow::Status DatasetRead(const std::string& airquality_basedir) {
   return arrow::Status::OK();
 }
 
+arrow::Status DatasetReadFromMetadata(const std::string& airquality_basedir) {
+  StartRecipe("CreatingADatasetFromMetadata");
+  std::shared_ptr<arrow::fs::FileSystem> fs =
+      std::make_shared<arrow::fs::LocalFileSystem>();
+
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::dataset::Dataset> dataset,
+                        OpenPartitionedDataset(fs, airquality_basedir));
+  ARROW_ASSIGN_OR_RAISE(arrow::dataset::FragmentIterator fragments,
+                        dataset->GetFragments());
+  int num_fragments = 0;
+  for (const arrow::Result<std::shared_ptr<arrow::dataset::Fragment>>& fragment :
+       fragments) {
+    ARROW_RETURN_NOT_OK(fragment.status());
+    num_fragments++;
+  }
+  rout << "Created a dataset with " << num_fragments << " fragments and the schema:"
+       << std::endl
+       << std::endl
+       << dataset->schema()->ToString() << std::endl;
+  EndRecipe("CreatingADatasetFromMetadata");
+
+  arrow::dataset::ScannerBuilder scanner_builder(dataset);
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::dataset::Scanner> scanner,
+                        scanner_builder.Finish());
+  ARROW_ASSIGN_OR_RAISE(int64_t num_rows, scanner->CountRows());
+  EXPECT_EQ(num_rows, 153);
+  EXPECT_TRUE(dataset->schema()->GetFieldByName("Month") != nullptr);
+  return arrow::Status::OK();
+}
+
+/// \brief Configure the dataset writer to produce evenly sized row groups and files
+///
+/// By default every batch that reaches the writer is split by partition and written
+/// immediately, so data spread over many partitions ends up in many tiny row groups.
+/// Here the writer buffers rows for each partition until a full row group is ready
+/// and starts a new file after a fixed number of row groups.  Row counts are
+/// estimated from the average in-memory size of a row in `sample`.
+arrow::Status ConfigureSizedWrite(
+    const arrow::Table& sample, int64_t target_row_group_bytes, int64_t target_file_bytes,
+    uint32_t max_open_files, arrow::dataset::FileSystemDatasetWriteOptions* options) {
+  if (sample.num_rows() == 0) {
+    return arrow::Status::Invalid("Cannot estimate the row size of an empty table");
+  }
+  if (target_row_group_bytes <= 0 || target_file_bytes < target_row_group_bytes) {
+    return arrow::Status::Invalid(
+        "Target file size must be at least as large as the target row group size");
+  }
+  int64_t bytes_per_row =
+      std::max<int64_t>(1, arrow::util::TotalBufferSize(sample) / sample.num_rows());
+  uint64_t rows_per_group =
+      static_cast<uint64_t>(std::max<int64_t>(1, target_row_group_bytes / bytes_per_row));
+  uint64_t row_groups_per_file =
+      static_cast<uint64_t>(target_file_bytes / target_row_group_bytes);
+
+  options->min_rows_per_group = rows_per_group;
+  options->max_rows_per_group = rows_per_group;
+  // A whole number of row groups in every file keeps the files the same size
+  options->max_rows_per_file = rows_per_group * row_groups_per_file;
+  // When more files than this are open the least recently used one is closed.  A
+  // partition that receives more data later will then start a new, smaller file.
+  options->max_open_files = max_open_files;
+  return arrow::Status::OK();
+}
+
+struct DatasetWriteStats {
+  int64_t num_files = 0;
+  int64_t num_row_groups = 0;
+};
+
+/// \brief Write `table` with `write_options`, delivered in small batches as is
+/// typical of data arriving from a stream
+arrow::Status WriteInSmallBatches(
+    const std::shared_ptr<arrow::Table>& table,
+    const arrow::dataset::FileSystemDatasetWriteOptions& write_options) {
+  ARROW_RETURN_NOT_OK(
+      write_options.filesystem->DeleteDirContents(write_options.base_dir,
+                                                  /*missing_dir_ok=*/true));
+  std::shared_ptr<arrow::TableBatchReader> table_reader =
+      std::make_shared<arrow::TableBatchReader>(*table);
+  table_reader->set_chunksize(64);
+  std::shared_ptr<arrow::dataset::ScannerBuilder> scanner_builder =
+      arrow::dataset::ScannerBuilder::FromRecordBatchReader(std::move(table_reader));
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::dataset::Scanner> write_scanner,
+                        scanner_builder->Finish());
+  return arrow::dataset::FileSystemDataset::Write(write_options,
+                                                  std::move(write_scanner));
+}
+
+/// \brief Write `table` in small batches, then count the files and row groups written
+/// and check that all of the rows can be read back
+arrow::Result<DatasetWriteStats> MeasureDatasetWrite(
+    const std::shared_ptr<arrow::Table>& table,
+    const arrow::dataset::FileSystemDatasetWriteOptions& write_options) {
+  ARROW_RETURN_NOT_OK(WriteInSmallBatches(table, write_options));
+
+  DatasetWriteStats stats;
+  std::shared_ptr<arrow::fs::FileSystem> fs = write_options.filesystem;
+  arrow::fs::FileSelector selector;
+  selector.base_dir = write_options.base_dir;
+  selector.recursive = true;
+  ARROW_ASSIGN_OR_RAISE(std::vector<arrow::fs::FileInfo> file_infos,
+                        fs->GetFileInfo(selector));
+  for (const arrow::fs::FileInfo& file_info : file_infos) {
+    if (!file_info.IsFile()) continue;
+    ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::io::RandomAccessFile> input,
+                          fs->OpenInputFile(file_info));
+    std::unique_ptr<parquet::ParquetFileReader> reader =
+        parquet::ParquetFileReader::Open(std::move(input));
+    stats.num_files++;
+    stats.num_row_groups += reader->metadata()->num_row_groups();
+  }
+
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::dataset::Dataset> dataset,
+                        OpenPartitionedDataset(fs, write_options.base_dir));
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::dataset::ScannerBuilder> scanner_builder,
+                        dataset->NewScan());
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::dataset::Scanner> scanner,
+                        scanner_builder->Finish());
+  ARROW_ASSIGN_OR_RAISE(int64_t num_rows, scanner->CountRows());
+  if (num_rows != table->num_rows()) {
+    return arrow::Status::Invalid("Expected to read back ", table->num_rows(),
+                                  " rows but read ", num_rows);
+  }
+  return stats;
+}
+
+arrow::Status CompareDatasetWriters(const std::shared_ptr<arrow::Table>& airquality) {
+  std::shared_ptr<arrow::fs::FileSystem> fs =
+      std::make_shared<arrow::fs::LocalFileSystem>();
+  // Removed, along with both copies of the data, when we return
+  ARROW_ASSIGN_OR_RAISE(std::unique_ptr<arrow::internal::TemporaryDir> temp_dir,
+                        arrow::internal::TemporaryDir::Make("cookbook_cpp_airquality_"));
+  std::string default_dir = TemporaryDirPath(temp_dir.get()) + "/default";
+  std::string sized_dir = TemporaryDirPath(temp_dir.get()) + "/sized";
+  // Repeat the data so that each partition receives rows from many batches
+  std::vector<std::shared_ptr<arrow::Table>> copies(20, airquality);
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Table> table,
+                        arrow::ConcatenateTables(copies));
+
+  ARROW_ASSIGN_OR_RAISE(arrow::dataset::FileSystemDatasetWriteOptions default_options,
+                        MakeAirQualityWriteOptions(fs, default_dir));
+  ARROW_ASSIGN_OR_RAISE(DatasetWriteStats default_stats,
+                        MeasureDatasetWrite(table, default_options));
+
+  StartRecipe("WritingEvenlySizedFiles");
+  ARROW_ASSIGN_OR_RAISE(arrow::dataset::FileSystemDatasetWriteOptions sized_options,
+                        MakeAirQualityWriteOptions(fs, sized_dir));
+  ARROW_RETURN_NOT_OK(ConfigureSizedWrite(*airquality, /*target_row_group_bytes=*/1 << 20,
+                                          /*target_file_bytes=*/64 << 20,
+                                          /*max_open_files=*/256, &sized_options));
+  rout << "Writing row groups of " << sized_options.min_rows_per_group
+       << " rows and files of at most " << sized_options.max_rows_per_file << " rows"
+       << std::endl;
+  ARROW_ASSIGN_OR_RAISE(DatasetWriteStats sized_stats,
+                        MeasureDatasetWrite(table, sized_options));
+  EndRecipe("WritingEvenlySizedFiles");
+
+  StartRecipe("ComparingDatasetWriters");
+  rout << "Wrote " << table->num_rows() << " rows" << std::endl;
+  rout << "Default writer: " << default_stats.num_files << " files, "
+       << default_stats.num_row_groups << " row groups" << std::endl;
+  rout << "Sized writer: " << sized_stats.num_files << " files, "
+       << sized_stats.num_row_groups << " row groups" << std::endl;
+  EndRecipe("ComparingDatasetWriters");
+
+  EXPECT_LE(sized_stats.num_files, default_stats.num_files);
+  EXPECT_LT(sized_stats.num_row_groups, default_stats.num_row_groups);
+  return arrow::Status::OK();
+}
+
+/// \brief Rough size of one row of `schema` once decoded into memory
+int64_t EstimateRowBytes(const arrow::Schema& schema) {
+  int64_t row_bytes = 0;
+  for (const std::shared_ptr<arrow::Field>& field : schema.fields()) {
+    const auto* fixed_width =
+        dynamic_cast<const arrow::FixedWidthType*>(field->type().get());
+    if (fixed_width != nullptr) {
+      // One extra byte covers the validity bitmap and rounds up boolean values
+      row_bytes += fixed_width->bit_width() / 8 + 1;
+    } else {
+      // There is no way to know the size of strings, lists, etc. without reading
+      // them so we guess
+      row_bytes += 64;
+    }
+  }
+  return std::max<int64_t>(1, row_bytes);
+}
+
+/// \brief Scan a dataset one batch at a time while staying under a memory budget
+///
+/// Unlike Scanner::ToTable this never materializes the whole dataset.  The next batch
+/// is only requested once `consumer` has returned, so a slow consumer slows down the
+/// scan instead of letting batches pile up in memory.  The batch size is chosen so
+/// that the batches in memory fit into `memory_budget` and the scanner only reads
+/// ahead by a single batch from a single file.
+///
+/// Only memory taken from `pool` counts against the budget: the decoded batches and the
+/// small buffer the pages are read through.  I/O buffers the files allocate themselves
+/// come from their IO context and are not counted.  The Parquet reader decodes a whole
+/// row group before slicing it into batches, so row groups must be written smaller
+/// than the budget.
+arrow::Status ScanWithMemoryBudget(
+    const std::shared_ptr<arrow::dataset::Dataset>& dataset, int64_t memory_budget,
+    arrow::MemoryPool* pool,
+    const std::function<arrow::Status(const arrow::RecordBatch&)>& consumer) {
+  // The batch held by the consumer and the one being read ahead, which may need up to
+  // twice its size in scratch space
+  constexpr int64_t kBatchesInFlight = 4;
+  int64_t row_bytes = EstimateRowBytes(*dataset->schema());
+  int64_t batch_size = memory_budget / (kBatchesInFlight * row_bytes);
+  if (batch_size <= 0) {
+    return arrow::Status::Invalid("A memory budget of ", memory_budget,
+                                  " bytes is too small to hold a single row");
+  }
+  // Read pages through a small buffer instead of loading whole column chunks
+  std::shared_ptr<arrow::dataset::ParquetFragmentScanOptions> parquet_options =
+      std::make_shared<arrow::dataset::ParquetFragmentScanOptions>();
+  parquet_options->reader_properties->enable_buffered_stream();
+  parquet_options->arrow_reader_properties->set_pre_buffer(false);
+
+  arrow::dataset::ScannerBuilder scanner_builder(dataset);
+  ARROW_RETURN_NOT_OK(scanner_builder.Pool(pool));
+  ARROW_RETURN_NOT_OK(scanner_builder.UseThreads(false));
+  ARROW_RETURN_NOT_OK(scanner_builder.BatchSize(batch_size));
+  ARROW_RETURN_NOT_OK(scanner_builder.BatchReadahead(1));
+  ARROW_RETURN_NOT_OK(scanner_builder.FragmentReadahead(1));
+  ARROW_RETURN_NOT_OK(scanner_builder.FragmentScanOptions(parquet_options));
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::dataset::Scanner> scanner,
+                        scanner_builder.Finish());
+
+  ARROW_ASSIGN_OR_RAISE(arrow::dataset::TaggedRecordBatchGenerator batches,
+                        scanner->ScanBatchesAsync());
+  while (true) {
+    arrow::Future<arrow::dataset::TaggedRecordBatch> next = batches();
+    ARROW_ASSIGN_OR_RAISE(arrow::dataset::TaggedRecordBatch batch, next.result());
+    if (arrow::IsIterationEnd(batch)) {
+      return arrow::Status::OK();
+    }
+    ARROW_RETURN_NOT_OK(consumer(*batch.record_batch));
+  }
+}
+
+arrow::Status ScanLargeDatasetWithBudget(
+    const std::shared_ptr<arrow::Table>& airquality) {
+  // Write a copy of the data that is larger than our memory budget
+  std::shared_ptr<arrow::fs::FileSystem> fs =
+      std::make_shared<arrow::fs::LocalFileSystem>();
+  ARROW_ASSIGN_OR_RAISE(std::unique_ptr<arrow::internal::TemporaryDir> temp_dir,
+                        arrow::internal::TemporaryDir::Make("cookbook_cpp_airquality_"));
+  std::string large_dir = TemporaryDirPath(temp_dir.get());
+  std::vector<std::shared_ptr<arrow::Table>> copies(1000, airquality);
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Table> large_table,
+                        arrow::ConcatenateTables(copies));
+  ARROW_ASSIGN_OR_RAISE(large_table, large_table->CombineChunks());
+  ARROW_ASSIGN_OR_RAISE(arrow::dataset::FileSystemDatasetWriteOptions write_options,
+                        MakeAirQualityWriteOptions(fs, large_dir));
+  // A single file of row groups that each fit into the memory budget
+  write_options.partitioning = arrow::dataset::Partitioning::Default();
+  ARROW_RETURN_NOT_OK(ConfigureSizedWrite(*airquality, /*target_row_group_bytes=*/1 << 17,
+                                          /*target_file_bytes=*/64 << 20,
+                                          /*max_open_files=*/256, &write_options));
+  std::shared_ptr<arrow::dataset::ScannerBuilder> write_scanner_builder =
+      arrow::dataset::ScannerBuilder::FromRecordBatchReader(
+          std::make_shared<arrow::TableBatchReader>(*large_table));
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::dataset::Scanner> write_scanner,
+                        write_scanner_builder->Finish());
+  ARROW_RETURN_NOT_OK(
+      arrow::dataset::FileSystemDataset::Write(write_options, std::move(write_scanner)));
+
+  StartRecipe("ScanningADatasetInBatches");
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::dataset::Dataset> dataset,
+                        OpenPartitionedDataset(fs, large_dir));
+
+  // A proxy pool keeps track of how much memory the scan allocates
+  arrow::ProxyMemoryPool pool(arrow::default_memory_pool());
+  constexpr int64_t kMemoryBudget = 1 << 20;
+  int64_t num_rows = 0;
+  int64_t num_bytes = 0;
+  ARROW_RETURN_NOT_OK(ScanWithMemoryBudget(
+      dataset, kMemoryBudget, &pool, [&](const arrow::RecordBatch& batch) {
+        num_rows += batch.num_rows();
+        num_bytes += arrow::util::TotalBufferSize(batch);
+        return arrow::Status::OK();
+      }));
+  rout << "Scanned " << num_rows << " rows (" << num_bytes << " bytes)" << std::endl;
+  rout << "Memory budget was " << kMemoryBudget << " bytes" << std::endl;
+  EndRecipe("ScanningADatasetInBatches");
+
+  EXPECT_EQ(num_rows, large_table->num_rows());
+  EXPECT_GT(num_bytes, kMemoryBudget);
+  EXPECT_LT(pool.max_memory(), kMemoryBudget);
+  // Nothing the scan allocated may outlive it
+  EXPECT_EQ(pool.bytes_allocated(), 0);
+  return arrow::Status::OK();
+}
+
+arrow::Status ScanPartitionedDatasetWithBudget(const std::string& airquality_basedir) {
+  std::shared_ptr<arrow::fs::FileSystem> fs =
+      std::make_shared<arrow::fs::LocalFileSystem>();
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::dataset::Dataset> dataset,
+                        OpenPartitionedDataset(fs, airquality_basedir));
+  std::shared_ptr<arrow::Schema> scanned_schema;
+  int64_t num_rows = 0;
+  int64_t num_partition_nulls = 0;
+  ARROW_RETURN_NOT_OK(ScanWithMemoryBudget(
+      dataset, /*memory_budget=*/1 << 20, arrow::default_memory_pool(),
+      [&](const arrow::RecordBatch& batch) {
+        scanned_schema = batch.schema();
+        num_rows += batch.num_rows();
+        for (const std::string& name : {"Month", "Day"}) {
+          std::shared_ptr<arrow::Array> column = batch.GetColumnByName(name);
+          if (column == nullptr) {
+            return arrow::Status::Invalid("Scanned batch has no ", name, " column");
+          }
+          num_partition_nulls += column->null_count();
+        }
+        return arrow::Status::OK();
+      }));
+
+  // The partition columns are parsed from the paths and added to every batch
+  EXPECT_EQ(num_rows, 153);
+  EXPECT_EQ(num_partition_nulls, 0);
+  EXPECT_TRUE(scanned_schema != nullptr && scanned_schema->Equals(*dataset->schema()))
+      << (scanned_schema == nullptr ? "no batches" : scanned_schema->ToString());
+  return arrow::Status::OK();
+}
+
+enum class ClusterOrder {
+  /// Sort lexicographically by the cluster columns
+  kSort,
+  /// Sort along a Z-order curve, which keeps every cluster column reasonably
+  /// clustered instead of only the first one
+  kZOrder,
+};
+
+/// \brief Interleave the bits of the dense rank of each column into one key
+arrow::Result<std::shared_ptr<arrow::Array>> ZOrderKey(
+    const std::vector<std::shared_ptr<arrow::Array>>& columns) {
+  if (columns.empty() || columns.size() > 64) {
+    return arrow::Status::Invalid("Z-order needs between 1 and 64 columns");
+  }
+  int bits_per_column = 64 / static_cast<int>(columns.size());
+  int64_t length = columns[0]->length();
+  std::vector<uint64_t> keys(length, 0);
+  arrow::compute::RankOptions rank_options(arrow::compute::SortOrder::Ascending,
+                                           arrow::compute::NullPlacement::AtEnd,
+                                           arrow::compute::RankOptions::Dense);
+  for (size_t column_index = 0; column_index < columns.size(); column_index++) {
+    // Ranks map any comparable type onto [1, number of distinct values]
+    ARROW_ASSIGN_OR_RAISE(
+        arrow::Datum ranks_datum,
+        arrow::compute::CallFunction("rank", {columns[column_index]}, &rank_options));
+    std::shared_ptr<arrow::UInt64Array> ranks =
+        std::static_pointer_cast<arrow::UInt64Array>(ranks_datum.make_array());
+    // Drop low bits if there are more distinct values than bits to hold them
+    uint64_t max_rank = 0;
+    for (int64_t row = 0; row < length; row++) {
+      max_rank = std::max(max_rank, ranks->Value(row));
+    }
+    int shift = 0;
+    while (bits_per_column < 64 && (((max_rank + 1) >> shift) >> bits_per_column) != 0) {
+      shift++;
+    }
+    for (int64_t row = 0; row < length; row++) {
+      uint64_t rank = (ranks->Value(row) - 1) >> shift;
+      for (int bit = 0; bit < bits_per_column; bit++) {
+        uint64_t rank_bit = (rank >> bit) & 1;
+        keys[row] |= rank_bit << (bit * columns.size() + column_index);
+      }
+    }
+  }
+  arrow::UInt64Builder builder;
+  ARROW_RETURN_NOT_OK(builder.AppendValues(keys));
+  return builder.Finish();
+}
+
+/// \brief Reorder rows so that similar values of `cluster_columns` are stored together
+///
+/// Rows are grouped by `partition_columns` first so that each partition reaches the
+/// dataset writer in one piece.  Within a partition the rows are then ordered by the
+/// cluster columns, which gives every row group a narrow min/max range for those
+/// columns so that filters on them can skip most row groups.
+arrow::Result<std::shared_ptr<arrow::Table>> ClusterTable(
+    const std::shared_ptr<arrow::Table>& table,
+    const std::vector<std::string>& partition_columns,
+    const std::vector<std::string>& cluster_columns, ClusterOrder order) {
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::RecordBatch> batch,
+                        table->CombineChunksToBatch());
+  std::vector<arrow::compute::SortKey> sort_keys;
+  for (const std::string& name : partition_columns) {
+    arrow::compute::SortKey key(arrow::FieldRef(name),
+                                arrow::compute::SortOrder::Ascending);
+    sort_keys.push_back(std::move(key));
+  }
+  if (order == ClusterOrder::kSort) {
+    for (const std::string& name : cluster_columns) {
+      arrow::compute::SortKey key(arrow::FieldRef(name),
+                                  arrow::compute::SortOrder::Ascending);
+      sort_keys.push_back(std::move(key));
+    }
+  } else {
+    std::vector<std::shared_ptr<arrow::Array>> columns;
+    for (const std::string& name : cluster_columns) {
+      std::shared_ptr<arrow::Array> column = batch->GetColumnByName(name);
+      if (column == nullptr) {
+        return arrow::Status::Invalid("No column named ", name);
+      }
+      columns.push_back(std::move(column));
+    }
+    ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Array> key, ZOrderKey(columns));
+    ARROW_ASSIGN_OR_RAISE(batch, batch->AddColumn(batch->num_columns(),
+                                                  "__zorder_key", std::move(key)));
+    arrow::compute::SortKey zorder_key(arrow::FieldRef("__zorder_key"),
+                                       arrow::compute::SortOrder::Ascending);
+    sort_keys.push_back(std::move(zorder_key));
+  }
+
+  ARROW_ASSIGN_OR_RAISE(
+      std::shared_ptr<arrow::Array> indices,
+      arrow::compute::SortIndices(batch, arrow::compute::SortOptions(sort_keys)));
+  ARROW_ASSIGN_OR_RAISE(arrow::Datum sorted, arrow::compute::Take(batch, indices));
+  std::shared_ptr<arrow::RecordBatch> sorted_batch = sorted.record_batch();
+  if (order == ClusterOrder::kZOrder) {
+    ARROW_ASSIGN_OR_RAISE(sorted_batch,
+                          sorted_batch->RemoveColumn(sorted_batch->num_columns() - 1));
+  }
+  return arrow::Table::FromRecordBatches({sorted_batch});
+}
+
+struct RowGroupCounts {
+  int matching = 0;
+  int total = 0;
+};
+
+/// \brief Count how many row groups of a dataset might contain rows matching `filter`
+arrow::Result<RowGroupCounts> CountMatchingRowGroups(
+    const std::shared_ptr<arrow::dataset::Dataset>& dataset,
+    const arrow::compute::Expression& filter) {
+  ARROW_ASSIGN_OR_RAISE(arrow::compute::Expression bound_filter,
+                        filter.Bind(*dataset->schema()));
+  ARROW_ASSIGN_OR_RAISE(arrow::dataset::FragmentIterator fragments,
+                        dataset->GetFragments());
+  RowGroupCounts counts;
+  for (const arrow::Result<std::shared_ptr<arrow::dataset::Fragment>>& maybe_fragment :
+       fragments) {
+    ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::dataset::Fragment> fragment,
+                          maybe_fragment);
+    auto* parquet_fragment =
+        dynamic_cast<arrow::dataset::ParquetFileFragment*>(fragment.get());
+    if (parquet_fragment == nullptr) {
+      return arrow::Status::Invalid("Expected a parquet fragment");
+    }
+    ARROW_RETURN_NOT_OK(parquet_fragment->EnsureCompleteMetadata());
+    counts.total += parquet_fragment->metadata()->num_row_groups();
+    // Only the row groups whose statistics can satisfy the filter are kept
+    ARROW_ASSIGN_OR_RAISE(arrow::dataset::FragmentVector row_groups,
+                          parquet_fragment->SplitByRowGroup(bound_filter));
+    counts.matching += static_cast<int>(row_groups.size());
+  }
+  return counts;
+}
+
+arrow::Status CompareClusteredWrites(const std::shared_ptr<arrow::Table>& airquality) {
+  std::shared_ptr<arrow::fs::FileSystem> fs =
+      std::make_shared<arrow::fs::LocalFileSystem>();
+  std::vector<std::shared_ptr<arrow::Table>> copies(100, airquality);
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Table> table,
+                        arrow::ConcatenateTables(copies));
+  // Partition only by Month so that each partition holds enough rows for
+  // several row groups
+  std::shared_ptr<arrow::dataset::Partitioning> month_partitioning =
+      std::make_shared<arrow::dataset::HivePartitioning>(
+          arrow::schema({arrow::field("Month", arrow::int32())}));
+  arrow::compute::Expression filter = arrow::compute::and_(
+      arrow::compute::greater_equal(arrow::compute::field_ref("Ozone"),
+                                    arrow::compute::literal(30)),
+      arrow::compute::less(arrow::compute::field_ref("Ozone"),
+                           arrow::compute::literal(40)));
+
+  std::vector<std::pair<std::string, std::optional<ClusterOrder>>> variants = {
+      {"Unclustered", std::nullopt},
+      {"Sorted by Ozone, Temp", ClusterOrder::kSort},
+      {"Z-ordered by Ozone, Temp", ClusterOrder::kZOrder}};
+  ARROW_ASSIGN_OR_RAISE(std::unique_ptr<arrow::internal::TemporaryDir> temp_dir,
+                        arrow::internal::TemporaryDir::Make("cookbook_cpp_airquality_"));
+  std::vector<RowGroupCounts> results;
+  for (size_t i = 0; i < variants.size(); i++) {
+    std::string base_dir =
+        TemporaryDirPath(temp_dir.get()) + "/clustered_" + std::to_string(i);
+    std::shared_ptr<arrow::Table> to_write = table;
+    if (variants[i].second.has_value()) {
+      ARROW_ASSIGN_OR_RAISE(to_write, ClusterTable(table, {"Month"}, {"Ozone", "Temp"},
+                                                   *variants[i].second));
+    }
+    ARROW_ASSIGN_OR_RAISE(arrow::dataset::FileSystemDatasetWriteOptions write_options,
+                          MakeAirQualityWriteOptions(fs, base_dir));
+    write_options.partitioning = month_partitioning;
+    write_options.min_rows_per_group = 256;
+    write_options.max_rows_per_group = 256;
+    // Keep the clustered order when the writer uses multiple threads
+    write_options.preserve_order = true;
+    std::shared_ptr<arrow::dataset::ScannerBuilder> scanner_builder =
+        arrow::dataset::ScannerBuilder::FromRecordBatchReader(
+            std::make_shared<arrow::TableBatchReader>(*to_write));
+    ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::dataset::Scanner> scanner,
+                          scanner_builder->Finish());
+    ARROW_RETURN_NOT_OK(
+        arrow::dataset::FileSystemDataset::Write(write_options, std::move(scanner)));
+
+    ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::dataset::Dataset> dataset,
+                          OpenPartitionedDataset(fs, base_dir));
+    ARROW_ASSIGN_OR_RAISE(RowGroupCounts counts, CountMatchingRowGroups(dataset, filter));
+    results.push_back(counts);
+  }
+
+  StartRecipe("ComparingClusteredWrites");
+  rout << "Filter: " << filter.ToString() << std::endl;
+  for (size_t i = 0; i < variants.size(); i++) {
+    rout << variants[i].first << ": must read " << results[i].matching << " of "
+         << results[i].total << " row groups" << std::endl;
+  }
+  EndRecipe("ComparingClusteredWrites");
+
+  EXPECT_LT(results[1].matching, results[0].matching);
+  EXPECT_LT(results[2].matching, results[0].matching);
+  return arrow::Status::OK();
+}
+
+/// \brief A minimal bloom filter over 64-bit hashes
+///
+/// Answers "might this value be present?" with no false negatives and roughly a 1%
+/// false positive rate when given 10 bits per inserted value.
+class BloomFilter {
+ public:
+  explicit BloomFilter(int64_t num_bits)
+      : words_((std::max<int64_t>(num_bits, 64) + 63) / 64, 0) {}
+
+  static BloomFilter FromBytes(std::string_view bytes) {
+    BloomFilter filter(static_cast<int64_t>(bytes.size()) * 8);
+    std::memcpy(filter.words_.data(), bytes.data(), filter.words_.size() * 8);
+    return filter;
+  }
+
+  // The bit mixing step of splitmix64, spreads similar values across all bits
+  static uint64_t Hash(double value) {
+    // Make sure 0.0 and -0.0 hash the same
+    if (value == 0) value = 0;
+    uint64_t x;
+    std::memcpy(&x, &value, sizeof(x));
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+  }
+
+  void Insert(uint64_t hash) {
+    for (int i = 0; i < kNumHashes; i++) {
+      uint64_t bit = BitIndex(hash, i);
+      words_[bit / 64] |= uint64_t{1} << (bit % 64);
+    }
+  }
+
+  bool MightContain(uint64_t hash) const {
+    for (int i = 0; i < kNumHashes; i++) {
+      uint64_t bit = BitIndex(hash, i);
+      if ((words_[bit / 64] & (uint64_t{1} << (bit % 64))) == 0) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  std::string_view bytes() const {
+    return {reinterpret_cast<const char*>(words_.data()), words_.size() * 8};
+  }
+
+ private:
+  static constexpr int kNumHashes = 4;
+
+  // Derive each probe from two halves of the hash (Kirsch-Mitzenmacher)
+  uint64_t BitIndex(uint64_t hash, int i) const {
+    uint64_t h1 = hash & 0xffffffff;
+    uint64_t h2 = hash >> 32;
+    return (h1 + i * h2) % (words_.size() * 64);
+  }
+
+  std::vector<uint64_t> words_;
+};  // BloomFilter
+
+/// \brief Build a sidecar index with min/max and a bloom filter for each row group
+///
+/// The row groups are indexed as they are written, by the file writers of an
+/// IndexingParquetFileFormat, so no file has to be read back.  Only numeric columns are
+/// supported.
+class LookupIndexBuilder {
+ public:
+  LookupIndexBuilder(std::string base_dir, std::vector<std::string> columns)
+      : base_dir_(std::move(base_dir)), columns_(std::move(columns)) {
+    std::vector<std::shared_ptr<arrow::Field>> fields = {
+        arrow::field("path", arrow::utf8()), arrow::field("row_group", arrow::int32())};
+    for (const std::string& column : columns_) {
+      fields.push_back(arrow::field(column + "_min", arrow::float64()));
+      fields.push_back(arrow::field(column + "_max", arrow::float64()));
+      fields.push_back(arrow::field(column + "_bloom", arrow::binary()));
+    }
+    schema_ = arrow::schema(std::move(fields));
+  }
+
+  const std::string& base_dir() const { return base_dir_; }
+
+  /// \brief Create the single index row that describes one row group
+  arrow::Result<std::shared_ptr<arrow::RecordBatch>> IndexRowGroup(
+      const std::string& path, int row_group, const arrow::RecordBatch& batch) const {
+    std::vector<std::shared_ptr<arrow::Array>> arrays;
+    ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Array> path_array,
+                          arrow::MakeArrayFromScalar(arrow::StringScalar(path), 1));
+    ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Array> row_group_array,
+                          arrow::MakeArrayFromScalar(arrow::Int32Scalar(row_group), 1));
+    arrays.push_back(std::move(path_array));
+    arrays.push_back(std::move(row_group_array));
+
+    for (const std::string& column : columns_) {
+      std::shared_ptr<arrow::Array> array = batch.GetColumnByName(column);
+      if (array == nullptr) {
+        return arrow::Status::Invalid("Cannot index missing column ", column);
+      }
+      ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Array> as_double,
+                            arrow::compute::Cast(*array, arrow::float64()));
+      const auto& values = static_cast<const arrow::DoubleArray&>(*as_double);
+
+      arrow::DoubleBuilder min_builder;
+      arrow::DoubleBuilder max_builder;
+      BloomFilter bloom_filter(std::max<int64_t>(1, values.length()) * 10);
+      bool any_valid = false;
+      double min = 0;
+      double max = 0;
+      for (std::optional<double> value : values) {
+        if (!value.has_value()) continue;
+        min = any_valid ? std::min(min, *value) : *value;
+        max = any_valid ? std::max(max, *value) : *value;
+        any_valid = true;
+        bloom_filter.Insert(BloomFilter::Hash(*value));
+      }
+      // A row group with only nulls can never match a lookup
+      ARROW_RETURN_NOT_OK(any_valid ? min_builder.Append(min) : min_builder.AppendNull());
+      ARROW_RETURN_NOT_OK(any_valid ? max_builder.Append(max) : max_builder.AppendNull());
+      arrow::BinaryBuilder bloom_builder;
+      ARROW_RETURN_NOT_OK(bloom_builder.Append(bloom_filter.bytes()));
+
+      std::vector<arrow::ArrayBuilder*> builders = {&min_builder, &max_builder,
+                                                    &bloom_builder};
+      for (arrow::ArrayBuilder* builder : builders) {
+        ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Array> index_array,
+                              builder->Finish());
+        arrays.push_back(std::move(index_array));
+      }
+    }
+    return arrow::RecordBatch::Make(schema_, 1, std::move(arrays));
+  }
+
+  /// \brief Add the index rows of a file that has been written completely
+  ///
+  /// May be called from several threads at once.
+  void AddRows(std::vector<std::shared_ptr<arrow::RecordBatch>> rows) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (std::shared_ptr<arrow::RecordBatch>& row : rows) {
+      rows_.push_back(std::move(row));
+    }
+  }
+
+  arrow::Status WriteIndexFile(arrow::fs::FileSystem* fs) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Table> index,
+                          arrow::Table::FromRecordBatches(schema_, rows_));
+    ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::io::OutputStream> sink,
+                          fs->OpenOutputStream(base_dir_ + "/_index.arrow"));
+    ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::ipc::RecordBatchWriter> writer,
+                          arrow::ipc::MakeFileWriter(sink, schema_));
+    ARROW_RETURN_NOT_OK(writer->WriteTable(*index));
+    ARROW_RETURN_NOT_OK(writer->Close());
+    rows_.clear();
+    return sink->Close();
+  }
+
+ private:
+  std::string base_dir_;
+  std::vector<std::string> columns_;
+  std::shared_ptr<arrow::Schema> schema_;
+  std::mutex mutex_;
+  std::vector<std::shared_ptr<arrow::RecordBatch>> rows_;
+};  // LookupIndexBuilder
+
+/// \brief Wraps a parquet file writer and indexes every batch it writes
+///
+/// Every batch is written as a row group of its own, so the n-th batch is the n-th
+/// row group of the file.  The dataset writer already hands each row group to the
+/// file writer as one batch.
+class IndexingFileWriter : public arrow::dataset::FileWriter {
+ public:
+  IndexingFileWriter(std::shared_ptr<arrow::dataset::ParquetFileWriter> writer,
+                     LookupIndexBuilder* index_builder, std::string relative_path)
+      : arrow::dataset::FileWriter(writer->schema(), writer->options(),
+                                   /*destination=*/nullptr, writer->destination()),
+        writer_(std::move(writer)),
+        index_builder_(index_builder),
+        relative_path_(std::move(relative_path)) {}
+
+  arrow::Status Write(const std::shared_ptr<arrow::RecordBatch>& batch) override {
+    // ParquetFileWriter::Write may append the batch to the row group that is still
+    // open, WriteTable always starts a new one
+    ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Table> table,
+                          arrow::Table::FromRecordBatches({batch}));
+    ARROW_RETURN_NOT_OK(writer_->parquet_writer()->WriteTable(
+        *table, /*chunk_size=*/std::max<int64_t>(1, batch->num_rows())));
+    ARROW_ASSIGN_OR_RAISE(
+        std::shared_ptr<arrow::RecordBatch> row,
+        index_builder_->IndexRowGroup(relative_path_, static_cast<int>(rows_.size()),
+                                      *batch));
+    rows_.push_back(std::move(row));
+    row_group_lengths_.push_back(batch->num_rows());
+    return arrow::Status::OK();
+  }
+
+  // The wrapped writer finishes and closes the file, the index rows are only added
+  // once the file is complete
+  arrow::Future<> Finish() override {
+    return writer_->Finish().Then([this]() -> arrow::Status {
+      ARROW_RETURN_NOT_OK(CheckRowGroups());
+      ARROW_ASSIGN_OR_RAISE(bytes_written_, writer_->GetBytesWritten());
+      index_builder_->AddRows(std::move(rows_));
+      return arrow::Status::OK();
+    });
+  }
+
+ protected:
+  // Unused because Finish is overridden
+  arrow::Future<> FinishInternal() override { return arrow::Future<>::MakeFinished(); }
+
+ private:
+  /// \brief Check that the row groups of the closed file match the index rows
+  ///
+  /// WriteTable splits a batch longer than the max_row_group_length of the writer
+  /// properties into several row groups.
+  arrow::Status CheckRowGroups() const {
+    std::shared_ptr<parquet::FileMetaData> metadata =
+        writer_->parquet_writer()->metadata();
+    if (metadata->num_row_groups() != static_cast<int>(row_group_lengths_.size())) {
+      return arrow::Status::Invalid("Wrote ", row_group_lengths_.size(), " batches to ",
+                                    relative_path_, " but it has ",
+                                    metadata->num_row_groups(), " row groups");
+    }
+    for (int i = 0; i < metadata->num_row_groups(); i++) {
+      if (metadata->RowGroup(i)->num_rows() != row_group_lengths_[i]) {
+        return arrow::Status::Invalid("Row group ", i, " of ", relative_path_, " has ",
+                                      metadata->RowGroup(i)->num_rows(),
+                                      " rows but the indexed batch had ",
+                                      row_group_lengths_[i]);
+      }
+    }
+    return arrow::Status::OK();
+  }
+
+  std::shared_ptr<arrow::dataset::ParquetFileWriter> writer_;
+  LookupIndexBuilder* index_builder_;
+  std::string relative_path_;
+  std::vector<std::shared_ptr<arrow::RecordBatch>> rows_;
+  std::vector<int64_t> row_group_lengths_;
+};  // IndexingFileWriter
+
+/// \brief A parquet format whose file writers add every row group to a lookup index
+///
+/// Use it for FileSystemDatasetWriteOptions::file_write_options, e.g. via
+/// DefaultWriteOptions.
+class IndexingParquetFileFormat : public arrow::dataset::ParquetFileFormat {
+ public:
+  explicit IndexingParquetFileFormat(LookupIndexBuilder* index_builder)
+      : index_builder_(index_builder) {}
+
+  arrow::Result<std::shared_ptr<arrow::dataset::FileWriter>> MakeWriter(
+      std::shared_ptr<arrow::io::OutputStream> destination,
+      std::shared_ptr<arrow::Schema> schema,
+      std::shared_ptr<arrow::dataset::FileWriteOptions> options,
+      arrow::fs::FileLocator destination_locator) const override {
+    const std::string& base_dir = index_builder_->base_dir();
+    const std::string& path = destination_locator.path;
+    if (path.compare(0, base_dir.size(), base_dir) != 0) {
+      return arrow::Status::Invalid("File ", path, " is not written under ", base_dir);
+    }
+    // Paths in the index are relative to the dataset directory
+    std::string relative_path = path.substr(base_dir.size());
+    relative_path.erase(0, relative_path.find_first_not_of('/'));
+
+    ARROW_ASSIGN_OR_RAISE(
+        std::shared_ptr<arrow::dataset::FileWriter> writer,
+        ParquetFileFormat::MakeWriter(std::move(destination), std::move(schema),
+                                      std::move(options),
+                                      std::move(destination_locator)));
+    std::shared_ptr<arrow::dataset::ParquetFileWriter> parquet_writer =
+        std::dynamic_pointer_cast<arrow::dataset::ParquetFileWriter>(writer);
+    if (parquet_writer == nullptr) {
+      return arrow::Status::Invalid("Expected a parquet writer for ", path);
+    }
+    return std::make_shared<IndexingFileWriter>(std::move(parquet_writer),
+                                                index_builder_, std::move(relative_path));
+  }
+
+ private:
+  LookupIndexBuilder* index_builder_;
+};  // IndexingParquetFileFormat
+
+/// \brief A sidecar index written by LookupIndexBuilder, loaded into memory
+///
+/// The bloom filters are deserialized once, when the index is loaded, so that many
+/// lookups can share them.
+class LookupIndex {
+ public:
+  static arrow::Result<std::shared_ptr<LookupIndex>> Make(const arrow::Table& table) {
+    ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Table> combined, table.CombineChunks());
+    auto index = std::make_shared<LookupIndex>();
+    index->num_rows_ = combined->num_rows();
+    ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Array> paths,
+                          GetColumn(*combined, "path", arrow::utf8()));
+    ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Array> row_groups,
+                          GetColumn(*combined, "row_group", arrow::int32()));
+    index->paths_ = std::static_pointer_cast<arrow::StringArray>(paths);
+    index->row_groups_ = std::static_pointer_cast<arrow::Int32Array>(row_groups);
+    for (const std::shared_ptr<arrow::Field>& field : combined->schema()->fields()) {
+      const std::string& name = field->name();
+      constexpr std::string_view kBloomSuffix = "_bloom";
+      if (name.size() <= kBloomSuffix.size() ||
+          name.compare(name.size() - kBloomSuffix.size(), kBloomSuffix.size(),
+                       kBloomSuffix) != 0) {
+        continue;
+      }
+      std::string column = name.substr(0, name.size() - kBloomSuffix.size());
+      ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Array> mins,
+                            GetColumn(*combined, column + "_min", arrow::float64()));
+      ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Array> maxes,
+                            GetColumn(*combined, column + "_max", arrow::float64()));
+      ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Array> blooms_array,
+                            GetColumn(*combined, name, arrow::binary()));
+      ColumnIndex& column_index = index->columns_[column];
+      column_index.mins = std::static_pointer_cast<arrow::DoubleArray>(mins);
+      column_index.maxes = std::static_pointer_cast<arrow::DoubleArray>(maxes);
+      auto blooms = std::static_pointer_cast<arrow::BinaryArray>(blooms_array);
+      for (int64_t i = 0; i < blooms->length(); i++) {
+        column_index.bloom_filters.push_back(BloomFilter::FromBytes(blooms->GetView(i)));
+      }
+    }
+    return index;
+  }
+
+  int64_t num_row_groups() const { return num_rows_; }
+
+  /// \brief Find the row groups that might contain `value` in `column`
+  arrow::Result<RowGroupSelection> Lookup(const std::string& column, double value) const {
+    auto found = columns_.find(column);
+    if (found == columns_.end()) {
+      return arrow::Status::Invalid("Column ", column, " is not indexed");
+    }
+    const ColumnIndex& column_index = found->second;
+    uint64_t hash = BloomFilter::Hash(value);
+    RowGroupSelection matches;
+    for (int64_t i = 0; i < num_rows_; i++) {
+      if (column_index.mins->IsNull(i) || value < column_index.mins->Value(i) ||
+          value > column_index.maxes->Value(i)) {
+        continue;
+      }
+      if (!column_index.bloom_filters[i].MightContain(hash)) {
+        continue;
+      }
+      matches[paths_->GetString(i)].push_back(row_groups_->Value(i));
+    }
+    return matches;
+  }
+
+ private:
+  /// \brief The one chunk of a column of an index whose chunks have been combined
+  static arrow::Result<std::shared_ptr<arrow::Array>> GetColumn(
+      const arrow::Table& index, const std::string& name,
+      const std::shared_ptr<arrow::DataType>& type) {
+    std::shared_ptr<arrow::ChunkedArray> column = index.GetColumnByName(name);
+    if (column == nullptr) {
+      return arrow::Status::Invalid("Not a lookup index, there is no ", name,
+                                    " column: ", index.schema()->ToString());
+    }
+    if (!column->type()->Equals(*type)) {
+      return arrow::Status::Invalid("Expected column ", name,
+                                    " of the lookup index to be ", type->ToString(),
+                                    " but it is ", column->type()->ToString());
+    }
+    // An empty table may have no chunks at all
+    if (column->num_chunks() == 0) {
+      return arrow::MakeEmptyArray(type);
+    }
+    return column->chunk(0);
+  }
+
+  struct ColumnIndex {
+    std::shared_ptr<arrow::DoubleArray> mins;
+    std::shared_ptr<arrow::DoubleArray> maxes;
+    std::vector<BloomFilter> bloom_filters;
+  };
+
+  int64_t num_rows_ = 0;
+  std::shared_ptr<arrow::StringArray> paths_;
+  std::shared_ptr<arrow::Int32Array> row_groups_;
+  std::unordered_map<std::string, ColumnIndex> columns_;
+};  // LookupIndex
+
+arrow::Result<std::shared_ptr<LookupIndex>> OpenLookupIndex(arrow::fs::FileSystem* fs,
+                                                            const std::string& base_dir) {
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::io::RandomAccessFile> input,
+                        fs->OpenInputFile(base_dir + "/_index.arrow"));
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::ipc::RecordBatchFileReader> reader,
+                        arrow::ipc::RecordBatchFileReader::Open(input));
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Table> index, reader->ToTable());
+  return LookupIndex::Make(*index);
+}
+
+/// \brief Restrict a dataset to the files and row groups selected by the index
+///
+/// Files that are not selected are dropped before they are ever opened.
+arrow::Result<std::shared_ptr<arrow::dataset::Dataset>> PruneDataset(
+    const std::shared_ptr<arrow::dataset::Dataset>& dataset, const std::string& base_dir,
+    const RowGroupSelection& row_groups) {
+  auto* fs_dataset = dynamic_cast<arrow::dataset::FileSystemDataset*>(dataset.get());
+  if (fs_dataset == nullptr) {
+    return arrow::Status::Invalid("Can only prune a FileSystemDataset");
+  }
+  ARROW_ASSIGN_OR_RAISE(arrow::dataset::FragmentIterator fragments,
+                        dataset->GetFragments());
+  std::vector<std::shared_ptr<arrow::dataset::FileFragment>> kept;
+  for (const arrow::Result<std::shared_ptr<arrow::dataset::Fragment>>& maybe_fragment :
+       fragments) {
+    ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::dataset::Fragment> fragment,
+                          maybe_fragment);
+    auto* parquet_fragment =
+        dynamic_cast<arrow::dataset::ParquetFileFragment*>(fragment.get());
+    if (parquet_fragment == nullptr) {
+      return arrow::Status::Invalid("Expected a parquet fragment");
+    }
+    std::string relative_path = parquet_fragment->source().path().substr(base_dir.size());
+    relative_path.erase(0, relative_path.find_first_not_of('/'));
+    auto match = row_groups.find(relative_path);
+    if (match == row_groups.end()) continue;
+    ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::dataset::Fragment> subset,
+                          parquet_fragment->Subset(match->second));
+    kept.push_back(std::static_pointer_cast<arrow::dataset::FileFragment>(subset));
+  }
+  return arrow::dataset::FileSystemDataset::Make(
+      dataset->schema(), dataset->partition_expression(), fs_dataset->format(),
+      fs_dataset->filesystem(), std::move(kept), fs_dataset->partitioning());
+}
+
+arrow::Result<int64_t> CountRowsMatching(
+    const std::shared_ptr<arrow::dataset::Dataset>& dataset,
+    const arrow::compute::Expression& filter) {
+  arrow::dataset::ScannerBuilder scanner_builder(dataset);
+  ARROW_RETURN_NOT_OK(scanner_builder.UseThreads(true));
+  ARROW_RETURN_NOT_OK(scanner_builder.Filter(filter));
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::dataset::Scanner> scanner,
+                        scanner_builder.Finish());
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Table> table, scanner->ToTable());
+  return table->num_rows();
+}
+
+arrow::Result<int64_t> CountRowsWithIndex(
+    const std::shared_ptr<arrow::dataset::Dataset>& dataset, const std::string& base_dir,
+    const LookupIndex& index, const std::string& column, double value) {
+  // Consult the index before any data file is opened
+  ARROW_ASSIGN_OR_RAISE(RowGroupSelection row_groups, index.Lookup(column, value));
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::dataset::Dataset> pruned,
+                        PruneDataset(dataset, base_dir, row_groups));
+  return CountRowsMatching(pruned,
+                           arrow::compute::equal(arrow::compute::field_ref(column),
+                                                 arrow::compute::literal(value)));
+}
+
+arrow::Status WriteIndexedAirQuality(const std::shared_ptr<arrow::Table>& table,
+                                     const std::shared_ptr<arrow::fs::FileSystem>& fs,
+                                     const std::string& base_dir) {
+  // Each row group holds rows from many days so min/max statistics alone can
+  // rarely rule one out
+  ARROW_ASSIGN_OR_RAISE(arrow::dataset::FileSystemDatasetWriteOptions write_options,
+                        MakeAirQualityWriteOptions(fs, base_dir));
+  write_options.partitioning = std::make_shared<arrow::dataset::HivePartitioning>(
+      arrow::schema({arrow::field("Month", arrow::int32())}));
+  write_options.min_rows_per_group = 256;
+  write_options.max_rows_per_group = 256;
+  LookupIndexBuilder index_builder(base_dir, {"Ozone", "Temp"});
+  std::shared_ptr<arrow::dataset::FileFormat> format =
+      std::make_shared<IndexingParquetFileFormat>(&index_builder);
+  write_options.file_write_options = format->DefaultWriteOptions();
+  ARROW_RETURN_NOT_OK(fs->DeleteDirContents(base_dir, /*missing_dir_ok=*/true));
+  std::shared_ptr<arrow::dataset::ScannerBuilder> write_scanner_builder =
+      arrow::dataset::ScannerBuilder::FromRecordBatchReader(
+          std::make_shared<arrow::TableBatchReader>(*table));
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::dataset::Scanner> write_scanner,
+                        write_scanner_builder->Finish());
+  ARROW_RETURN_NOT_OK(
+      arrow::dataset::FileSystemDataset::Write(write_options, std::move(write_scanner)));
+  return index_builder.WriteIndexFile(fs.get());
+}
+
+arrow::Status CompareIndexedLookups(const std::shared_ptr<arrow::Table>& airquality) {
+  std::shared_ptr<arrow::fs::FileSystem> fs =
+      std::make_shared<arrow::fs::LocalFileSystem>();
+  ARROW_ASSIGN_OR_RAISE(std::unique_ptr<arrow::internal::TemporaryDir> temp_dir,
+                        arrow::internal::TemporaryDir::Make("cookbook_cpp_airquality_"));
+  std::string base_dir = TemporaryDirPath(temp_dir.get());
+  std::vector<std::shared_ptr<arrow::Table>> copies(100, airquality);
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Table> table,
+                        arrow::ConcatenateTables(copies));
+  ARROW_RETURN_NOT_OK(WriteIndexedAirQuality(table, fs, base_dir));
+
+  StartRecipe("LookupWithSidecarIndex");
+  double ozone = 135;
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::dataset::Dataset> dataset,
+                        OpenPartitionedDataset(fs, base_dir));
+  // The index is loaded once and can serve any number of lookups
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<LookupIndex> index,
+                        OpenLookupIndex(fs.get(), base_dir));
+  ARROW_ASSIGN_OR_RAISE(RowGroupSelection row_groups, index->Lookup("Ozone", ozone));
+  ARROW_ASSIGN_OR_RAISE(int64_t indexed_rows,
+                        CountRowsWithIndex(dataset, base_dir, *index, "Ozone", ozone));
+
+  int num_row_groups = 0;
+  for (const auto& file_row_groups : row_groups) {
+    num_row_groups += static_cast<int>(file_row_groups.second.size());
+  }
+  arrow::compute::Expression filter = arrow::compute::equal(
+      arrow::compute::field_ref("Ozone"), arrow::compute::literal(ozone));
+  ARROW_ASSIGN_OR_RAISE(RowGroupCounts statistics_counts,
+                        CountMatchingRowGroups(dataset, filter));
+  rout << "Found " << indexed_rows << " rows with Ozone == " << ozone << std::endl;
+  rout << "Min/max statistics must read " << statistics_counts.matching << " of "
+       << statistics_counts.total << " row groups" << std::endl;
+  rout << "The index must read " << num_row_groups << " row groups in "
+       << row_groups.size() << " files" << std::endl;
+  EndRecipe("LookupWithSidecarIndex");
+
+  ARROW_ASSIGN_OR_RAISE(int64_t plain_rows, CountRowsMatching(dataset, filter));
+  EXPECT_EQ(indexed_rows, plain_rows);
+  EXPECT_GT(indexed_rows, 0);
+  EXPECT_LT(num_row_groups, statistics_counts.matching);
+  // Every row group that was written must have been indexed
+  EXPECT_EQ(index->num_row_groups(), statistics_counts.total);
+  return arrow::Status::OK();
+}
+
+arrow::Status CheckLookupIndexValidation() {
+  std::vector<std::shared_ptr<arrow::Field>> fields = {
+      arrow::field("path", arrow::utf8()), arrow::field("row_group", arrow::int32()),
+      arrow::field("Ozone_min", arrow::float64()),
+      arrow::field("Ozone_max", arrow::float64()),
+      arrow::field("Ozone_bloom", arrow::binary())};
+
+  // An index of a dataset without any row groups has no chunks
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Table> empty,
+                        arrow::Table::FromRecordBatches(arrow::schema(fields), {}));
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<LookupIndex> index, LookupIndex::Make(*empty));
+  EXPECT_EQ(index->num_row_groups(), 0);
+  ARROW_ASSIGN_OR_RAISE(RowGroupSelection row_groups, index->Lookup("Ozone", 135));
+  EXPECT_TRUE(row_groups.empty());
+
+  std::vector<std::shared_ptr<arrow::Field>> wrong_type = fields;
+  wrong_type[2] = arrow::field("Ozone_min", arrow::int32());
+  ARROW_ASSIGN_OR_RAISE(empty,
+                        arrow::Table::FromRecordBatches(arrow::schema(wrong_type), {}));
+  EXPECT_TRUE(LookupIndex::Make(*empty).status().IsInvalid());
+
+  std::vector<std::shared_ptr<arrow::Field>> missing_max = fields;
+  missing_max.erase(missing_max.begin() + 3);
+  ARROW_ASSIGN_OR_RAISE(empty,
+                        arrow::Table::FromRecordBatches(arrow::schema(missing_max), {}));
+  EXPECT_TRUE(LookupIndex::Make(*empty).status().IsInvalid());
+  return arrow::Status::OK();
+}
+
+/// \brief Create a wide airquality-like table with readings from many stations
+///
+/// Rows are ordered by station, as they would be if each station uploads its
+/// readings in one piece.
+arrow::Result<std::shared_ptr<arrow::Table>> MakeWideAirQuality(int num_stations,
+                                                                int rows_per_station,
+                                                                int num_sensors) {
+  std::mt19937 gen(42);
+  std::normal_distribution<double> reading(50.0, 20.0);
+  std::uniform_int_distribution<int32_t> temperature(55, 97);
+
+  std::vector<std::shared_ptr<arrow::Field>> fields = {
+      arrow::field("Station", arrow::utf8()), arrow::field("Temp", arrow::int32())};
+  arrow::StringBuilder station_builder;
+  arrow::Int32Builder temp_builder;
+  std::vector<arrow::DoubleBuilder> sensor_builders(num_sensors);
+  for (int sensor = 0; sensor < num_sensors; sensor++) {
+    fields.push_back(arrow::field("Sensor" + std::to_string(sensor), arrow::float64()));
+  }
+  for (int station = 0; station < num_stations; station++) {
+    std::string station_name = "station-" + std::to_string(station);
+    for (int row = 0; row < rows_per_station; row++) {
+      ARROW_RETURN_NOT_OK(station_builder.Append(station_name));
+      ARROW_RETURN_NOT_OK(temp_builder.Append(temperature(gen)));
+      for (arrow::DoubleBuilder& sensor_builder : sensor_builders) {
+        ARROW_RETURN_NOT_OK(sensor_builder.Append(reading(gen)));
+      }
+    }
+  }
+
+  std::vector<std::shared_ptr<arrow::Array>> columns;
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Array> stations, station_builder.Finish());
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Array> temps, temp_builder.Finish());
+  columns.push_back(std::move(stations));
+  columns.push_back(std::move(temps));
+  for (arrow::DoubleBuilder& sensor_builder : sensor_builders) {
+    ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Array> sensor, sensor_builder.Finish());
+    columns.push_back(std::move(sensor));
+  }
+  return arrow::Table::Make(arrow::schema(std::move(fields)), std::move(columns));
+}
+
+/// \brief Read a parquet file, decoding most columns only where the filter matches
+///
+/// First only the columns needed by the filter are decoded and the filter is
+/// evaluated.  The remaining columns are then decoded only for the row groups that
+/// have at least one match.  Parquet row groups are the smallest unit Arrow can
+/// decode on its own, so this helps most when matches are concentrated in a few row
+/// groups and the filter cannot be answered by the row group statistics (e.g. a
+/// substring match).
+arrow::Result<std::shared_ptr<arrow::Table>> ReadWithLateMaterialization(
+    parquet::arrow::FileReader* reader, const arrow::compute::Expression& filter,
+    int64_t* bytes_decoded) {
+  std::shared_ptr<arrow::Schema> schema;
+  ARROW_RETURN_NOT_OK(reader->GetSchema(&schema));
+  ARROW_ASSIGN_OR_RAISE(arrow::compute::Expression bound_filter, filter.Bind(*schema));
+
+  // Split the columns into those the filter needs and the rest
+  std::vector<bool> is_filter_column(schema->num_fields(), false);
+  for (const arrow::FieldRef& ref : arrow::compute::FieldsInExpression(bound_filter)) {
+    ARROW_ASSIGN_OR_RAISE(arrow::FieldPath path, ref.FindOne(*schema));
+    is_filter_column[path[0]] = true;
+  }
+  std::vector<int> filter_columns;
+  std::vector<int> other_columns;
+  for (int i = 0; i < schema->num_fields(); i++) {
+    (is_filter_column[i] ? filter_columns : other_columns).push_back(i);
+  }
+
+  std::vector<std::shared_ptr<arrow::RecordBatch>> matches;
+  for (int row_group = 0; row_group < reader->num_row_groups(); row_group++) {
+    // Phase 1: decode the filter columns and evaluate the filter
+    std::shared_ptr<arrow::Table> filter_table;
+#if ARROW_VERSION_MAJOR >= 24
+    ARROW_ASSIGN_OR_RAISE(filter_table, reader->ReadRowGroup(row_group, filter_columns));
+#else
+    ARROW_RETURN_NOT_OK(reader->ReadRowGroup(row_group, filter_columns, &filter_table));
+#endif
+    *bytes_decoded += arrow::util::TotalBufferSize(*filter_table);
+    ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::RecordBatch> filter_batch,
+                          filter_table->CombineChunksToBatch());
+    ARROW_ASSIGN_OR_RAISE(
+        arrow::Datum mask,
+        arrow::compute::ExecuteScalarExpression(bound_filter, *schema, filter_batch));
+    ARROW_ASSIGN_OR_RAISE(arrow::Datum filtered_filter_datum,
+                          arrow::compute::Filter(filter_batch, mask));
+    std::shared_ptr<arrow::RecordBatch> filtered_filter_batch =
+        filtered_filter_datum.record_batch();
+    int64_t num_matches = filtered_filter_batch->num_rows();
+    if (num_matches == 0) continue;
+
+    // Phase 2: decode the remaining columns, but only for this row group
+    std::shared_ptr<arrow::RecordBatch> other_batch;
+    if (!other_columns.empty()) {
+      std::shared_ptr<arrow::Table> other_table;
+#if ARROW_VERSION_MAJOR >= 24
+      ARROW_ASSIGN_OR_RAISE(other_table, reader->ReadRowGroup(row_group, other_columns));
+#else
+      ARROW_RETURN_NOT_OK(reader->ReadRowGroup(row_group, other_columns, &other_table));
+#endif
+      *bytes_decoded += arrow::util::TotalBufferSize(*other_table);
+      ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::RecordBatch> unfiltered,
+                            other_table->CombineChunksToBatch());
+      ARROW_ASSIGN_OR_RAISE(arrow::Datum filtered,
+                            arrow::compute::Filter(unfiltered, mask));
+      other_batch = filtered.record_batch();
+    }
+
+    // Put the columns back in their original order
+    std::vector<std::shared_ptr<arrow::Array>> columns;
+    int next_filter_column = 0;
+    int next_other_column = 0;
+    for (int i = 0; i < schema->num_fields(); i++) {
+      if (is_filter_column[i]) {
+        columns.push_back(filtered_filter_batch->column(next_filter_column++));
+      } else {
+        columns.push_back(other_batch->column(next_other_column++));
+      }
+    }
+    matches.push_back(arrow::RecordBatch::Make(schema, num_matches, std::move(columns)));
+  }
+  return arrow::Table::FromRecordBatches(schema, matches);
+}
+
+arrow::Status WriteWideAirQuality(const std::shared_ptr<arrow::Table>& table,
+                                  const std::shared_ptr<arrow::fs::FileSystem>& fs,
+                                  const std::string& base_dir, int64_t rows_per_file,
+                                  int64_t rows_per_group) {
+  std::shared_ptr<arrow::dataset::ParquetFileFormat> parquet_format =
+      std::make_shared<arrow::dataset::ParquetFileFormat>();
+  arrow::dataset::FileSystemDatasetWriteOptions write_options;
+  write_options.filesystem = fs;
+  write_options.base_dir = base_dir;
+  write_options.partitioning = arrow::dataset::Partitioning::Default();
+  write_options.basename_template = "part-{i}.parquet";
+  write_options.file_write_options = parquet_format->DefaultWriteOptions();
+  write_options.existing_data_behavior =
+      arrow::dataset::ExistingDataBehavior::kDeleteMatchingPartitions;
+  write_options.max_rows_per_file = rows_per_file;
+  write_options.min_rows_per_group = rows_per_group;
+  write_options.max_rows_per_group = rows_per_group;
+  write_options.preserve_order = true;
+  ARROW_RETURN_NOT_OK(fs->DeleteDirContents(base_dir, /*missing_dir_ok=*/true));
+  std::shared_ptr<arrow::dataset::ScannerBuilder> write_scanner_builder =
+      arrow::dataset::ScannerBuilder::FromRecordBatchReader(
+          std::make_shared<arrow::TableBatchReader>(*table));
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::dataset::Scanner> write_scanner,
+                        write_scanner_builder->Finish());
+  return arrow::dataset::FileSystemDataset::Write(write_options,
+                                                  std::move(write_scanner));
+}
+
+arrow::Status CompareLateMaterialization() {
+  std::shared_ptr<arrow::fs::FileSystem> fs =
+      std::make_shared<arrow::fs::LocalFileSystem>();
+  ARROW_ASSIGN_OR_RAISE(std::unique_ptr<arrow::internal::TemporaryDir> temp_dir,
+                        arrow::internal::TemporaryDir::Make("cookbook_cpp_airquality_"));
+  std::string base_dir = TemporaryDirPath(temp_dir.get());
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Table> table,
+                        MakeWideAirQuality(/*num_stations=*/100,
+                                           /*rows_per_station=*/1000,
+                                           /*num_sensors=*/16));
+  ARROW_RETURN_NOT_OK(WriteWideAirQuality(table, fs, base_dir, /*rows_per_file=*/25000,
+                                          /*rows_per_group=*/1000));
+
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::dataset::Dataset> dataset,
+                        OpenPartitionedDataset(fs, base_dir));
+  // Row group statistics cannot rule anything out for a substring match
+  arrow::compute::Expression filter =
+      arrow::compute::call("match_substring", {arrow::compute::field_ref("Station")},
+                           arrow::compute::MatchSubstringOptions("-42"));
+
+  // The regular scanner decodes every column of every row group
+  ARROW_ASSIGN_OR_RAISE(int64_t scanned_rows, CountRowsMatching(dataset, filter));
+
+  // Decode every column, as the regular scanner does, to compare the amount of data
+  std::vector<std::string> paths =
+      std::static_pointer_cast<arrow::dataset::FileSystemDataset>(dataset)->files();
+  int64_t full_bytes = 0;
+  for (const std::string& path : paths) {
+    ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::io::RandomAccessFile> input,
+                          fs->OpenInputFile(path));
+    ARROW_ASSIGN_OR_RAISE(
+        std::unique_ptr<parquet::arrow::FileReader> reader,
+        parquet::arrow::OpenFile(std::move(input), arrow::default_memory_pool()));
+    std::shared_ptr<arrow::Table> everything;
+#if ARROW_VERSION_MAJOR >= 24
+    ARROW_ASSIGN_OR_RAISE(everything, reader->ReadTable());
+#else
+    ARROW_RETURN_NOT_OK(reader->ReadTable(&everything));
+#endif
+    full_bytes += arrow::util::TotalBufferSize(*everything);
+  }
+
+  StartRecipe("LateMaterialization");
+  int64_t late_bytes = 0;
+  int64_t late_rows = 0;
+  for (const std::string& path : paths) {
+    ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::io::RandomAccessFile> input,
+                          fs->OpenInputFile(path));
+    ARROW_ASSIGN_OR_RAISE(
+        std::unique_ptr<parquet::arrow::FileReader> reader,
+        parquet::arrow::OpenFile(std::move(input), arrow::default_memory_pool()));
+    ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Table> matches,
+                          ReadWithLateMaterialization(reader.get(), filter, &late_bytes));
+    late_rows += matches->num_rows();
+  }
+  rout << "Found " << late_rows << " of " << table->num_rows() << " rows" << std::endl;
+  rout << "Late materialization decoded " << late_bytes << " bytes" << std::endl;
+  rout << "Decoding every column decodes " << full_bytes << " bytes" << std::endl;
+  EndRecipe("LateMaterialization");
+
+  EXPECT_EQ(late_rows, scanned_rows);
+  EXPECT_EQ(late_rows, 1000);
+  EXPECT_LT(late_bytes * 2, full_bytes);
+  return arrow::Status::OK();
+}
+
+/// \brief The formats and codecs worth comparing
+///
+/// Codecs that were not included in this build of Arrow are skipped.
+arrow::Result<std::vector<StorageFormat>> MakeStorageFormats() {
+  std::vector<StorageFormat> formats;
+
+  std::shared_ptr<arrow::dataset::ParquetFileFormat> parquet_format =
+      std::make_shared<arrow::dataset::ParquetFileFormat>();
+  for (arrow::Compression::type codec :
+       {arrow::Compression::UNCOMPRESSED, arrow::Compression::SNAPPY,
+        arrow::Compression::ZSTD, arrow::Compression::LZ4}) {
+    if (!arrow::util::Codec::IsAvailable(codec)) continue;
+    for (bool dictionary : {true, false}) {
+      parquet::WriterProperties::Builder properties_builder;
+      properties_builder.compression(codec);
+      if (dictionary) {
+        properties_builder.enable_dictionary();
+      } else {
+        properties_builder.disable_dictionary();
+      }
+      std::shared_ptr<arrow::dataset::ParquetFileWriteOptions> options =
+          std::static_pointer_cast<arrow::dataset::ParquetFileWriteOptions>(
+              parquet_format->DefaultWriteOptions());
+      options->writer_properties = properties_builder.build();
+      std::string name = "parquet/" + arrow::util::Codec::GetCodecAsString(codec);
+      formats.push_back({dictionary ? name + "/dictionary" : name, options});
+    }
+  }
+
+  std::shared_ptr<arrow::dataset::IpcFileFormat> ipc_format =
+      std::make_shared<arrow::dataset::IpcFileFormat>();
+  for (arrow::Compression::type codec :
+       {arrow::Compression::UNCOMPRESSED, arrow::Compression::LZ4_FRAME,
+        arrow::Compression::ZSTD}) {
+    if (!arrow::util::Codec::IsAvailable(codec)) continue;
+    std::shared_ptr<arrow::dataset::IpcFileWriteOptions> options =
+        std::static_pointer_cast<arrow::dataset::IpcFileWriteOptions>(
+            ipc_format->DefaultWriteOptions());
+    if (codec != arrow::Compression::UNCOMPRESSED) {
+      ARROW_ASSIGN_OR_RAISE(options->options->codec, arrow::util::Codec::Create(codec));
+    }
+    formats.push_back({"ipc/" + arrow::util::Codec::GetCodecAsString(codec), options});
+  }
+
+  std::shared_ptr<arrow::dataset::CsvFileFormat> csv_format =
+      std::make_shared<arrow::dataset::CsvFileFormat>();
+  formats.push_back({"csv", csv_format->DefaultWriteOptions()});
+  return formats;
+}
+
+/// \brief Write `table` in the given format and open the result as a dataset
+arrow::Result<std::shared_ptr<arrow::dataset::Dataset>> WriteStorageFormat(
+    const std::shared_ptr<arrow::fs::FileSystem>& fs, const std::string& base_dir,
+    const std::shared_ptr<arrow::Table>& table,
+    const std::shared_ptr<arrow::dataset::Partitioning>& partitioning,
+    const StorageFormat& format) {
+  std::shared_ptr<arrow::dataset::FileFormat> file_format =
+      format.write_options->format();
+
+  arrow::dataset::FileSystemDatasetWriteOptions write_options;
+  write_options.filesystem = fs;
+  write_options.base_dir = base_dir;
+  write_options.partitioning = partitioning;
+  write_options.basename_template = "part-{i}." + file_format->type_name();
+  write_options.file_write_options = format.write_options;
+  write_options.existing_data_behavior =
+      arrow::dataset::ExistingDataBehavior::kDeleteMatchingPartitions;
+  ARROW_RETURN_NOT_OK(fs->DeleteDirContents(base_dir, /*missing_dir_ok=*/true));
+  std::shared_ptr<arrow::dataset::ScannerBuilder> write_scanner_builder =
+      arrow::dataset::ScannerBuilder::FromRecordBatchReader(
+          std::make_shared<arrow::TableBatchReader>(*table));
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::dataset::Scanner> write_scanner,
+                        write_scanner_builder->Finish());
+  ARROW_RETURN_NOT_OK(
+      arrow::dataset::FileSystemDataset::Write(write_options, std::move(write_scanner)));
+
+  arrow::fs::FileSelector selector;
+  selector.base_dir = base_dir;
+  selector.recursive = true;
+  arrow::dataset::FileSystemFactoryOptions factory_options;
+  factory_options.partitioning = partitioning;
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::dataset::DatasetFactory> factory,
+                        arrow::dataset::FileSystemDatasetFactory::Make(
+                            fs, selector, file_format, factory_options));
+  return factory->Finish();
+}
+
+/// \brief The total size of the files under `base_dir`
+arrow::Result<int64_t> BytesOnDisk(arrow::fs::FileSystem* fs,
+                                   const std::string& base_dir) {
+  arrow::fs::FileSelector selector;
+  selector.base_dir = base_dir;
+  selector.recursive = true;
+  ARROW_ASSIGN_OR_RAISE(std::vector<arrow::fs::FileInfo> file_infos,
+                        fs->GetFileInfo(selector));
+  int64_t bytes_on_disk = 0;
+  for (const arrow::fs::FileInfo& file_info : file_infos) {
+    if (file_info.IsFile()) bytes_on_disk += file_info.size();
+  }
+  return bytes_on_disk;
+}
+
+arrow::Status CompareStorageFormats() {
+  std::shared_ptr<arrow::fs::FileSystem> fs =
+      std::make_shared<arrow::fs::LocalFileSystem>();
+  ARROW_ASSIGN_OR_RAISE(std::unique_ptr<arrow::internal::TemporaryDir> temp_dir,
+                        arrow::internal::TemporaryDir::Make("cookbook_cpp_airquality_"));
+  std::string base_dir = TemporaryDirPath(temp_dir.get());
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Table> table,
+                        MakeWideAirQuality(/*num_stations=*/20,
+                                           /*rows_per_station=*/1000,
+                                           /*num_sensors=*/4));
+  std::shared_ptr<arrow::dataset::Partitioning> partitioning =
+      std::make_shared<arrow::dataset::HivePartitioning>(
+          arrow::schema({arrow::field("Station", arrow::utf8())}));
+
+  StartRecipe("ComparingStorageFormats");
+  ARROW_ASSIGN_OR_RAISE(std::vector<StorageFormat> formats, MakeStorageFormats());
+  std::unordered_map<std::string, int64_t> sizes;
+  for (const StorageFormat& format : formats) {
+    ARROW_ASSIGN_OR_RAISE(
+        std::shared_ptr<arrow::dataset::Dataset> dataset,
+        WriteStorageFormat(fs, base_dir, table, partitioning, format));
+    ARROW_ASSIGN_OR_RAISE(int64_t bytes_on_disk, BytesOnDisk(fs.get(), base_dir));
+    rout << format.name << ": " << bytes_on_disk << " bytes" << std::endl;
+    sizes[format.name] = bytes_on_disk;
+
+    ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::dataset::ScannerBuilder> scan_builder,
+                          dataset->NewScan());
+    ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::dataset::Scanner> scanner,
+                          scan_builder->Finish());
+    ARROW_ASSIGN_OR_RAISE(int64_t num_rows, scanner->CountRows());
+    EXPECT_EQ(num_rows, table->num_rows()) << format.name;
+  }
+  EndRecipe("ComparingStorageFormats");
+
+  EXPECT_LT(sizes["parquet/uncompressed/dictionary"], sizes["csv"]);
+  EXPECT_LT(sizes["ipc/uncompressed"], sizes["csv"]);
+  if (sizes.count("parquet/zstd/dictionary") > 0) {
+    EXPECT_LT(sizes["parquet/zstd/dictionary"], sizes["parquet/uncompressed/dictionary"]);
+  }
+  return arrow::Status::OK();
+}
+
+std::ostream& operator<<(std::ostream& os, const RemoteScanSettings& settings) {
+  os << "pre_buffer=" << (settings.pre_buffer ? "true" : "false");
+  if (settings.pre_buffer) {
+    os << " hole_size_limit=" << settings.cache_options.hole_size_limit
+       << " range_size_limit=" << settings.cache_options.range_size_limit
+       << " lazy=" << (settings.cache_options.lazy ? "true" : "false");
+  }
+  return os << " fragment_readahead=" << settings.fragment_readahead;
+}
+
+/// \brief Settings derived from the latency and bandwidth of a filesystem
+///
+/// Every read pays the latency, so the column chunks a scan needs are read up front,
+/// with nearby ranges coalesced into one read as long as reading the gap between
+/// them costs less than starting another read.  Several files are read at the same
+/// time to hide the latency of opening them.  This is a cost model, not a measured
+/// optimum, so compare it with other settings on the real filesystem.
+RemoteScanSettings RemoteScanSettingsFor(double latency_seconds,
+                                         int64_t bandwidth_mib_per_sec) {
+  RemoteScanSettings settings;
+  settings.pre_buffer = true;
+  settings.cache_options = arrow::io::CacheOptions::MakeFromNetworkMetrics(
+      std::max<int64_t>(1, static_cast<int64_t>(latency_seconds * 1000)),
+      bandwidth_mib_per_sec);
+  settings.fragment_readahead = arrow::dataset::kDefaultFragmentReadahead;
+  return settings;
+}
+
+/// \brief Open a parquet dataset through a filesystem that adds a delay of about
+/// `latency_seconds` to every call and every read
+///
+/// arrow::fs::SlowFileSystem is a simple way to see how a scan behaves on an object
+/// store without talking to one.
+arrow::Result<std::shared_ptr<arrow::dataset::Dataset>> OpenWithLatency(
+    const std::shared_ptr<arrow::fs::FileSystem>& fs, const std::string& base_dir,
+    double latency_seconds) {
+  std::shared_ptr<arrow::fs::FileSystem> slow_fs =
+      std::make_shared<arrow::fs::SlowFileSystem>(fs, latency_seconds, /*seed=*/42);
+  arrow::fs::FileSelector selector;
+  selector.base_dir = base_dir;
+  selector.recursive = true;
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::dataset::DatasetFactory> factory,
+                        arrow::dataset::FileSystemDatasetFactory::Make(
+                            slow_fs, selector,
+                            std::make_shared<arrow::dataset::ParquetFileFormat>(),
+                            arrow::dataset::FileSystemFactoryOptions()));
+  return factory->Finish();
+}
+
+/// \brief Create a scanner for `columns` of a parquet dataset that reads with the
+/// given settings
+arrow::Result<std::shared_ptr<arrow::dataset::Scanner>> MakeRemoteScanner(
+    const std::shared_ptr<arrow::dataset::Dataset>& dataset,
+    const std::vector<std::string>& columns, const RemoteScanSettings& settings) {
+  std::shared_ptr<arrow::dataset::ParquetFragmentScanOptions> parquet_options =
+      std::make_shared<arrow::dataset::ParquetFragmentScanOptions>();
+  parquet_options->arrow_reader_properties->set_pre_buffer(settings.pre_buffer);
+  parquet_options->arrow_reader_properties->set_cache_options(settings.cache_options);
+
+  arrow::dataset::ScannerBuilder scanner_builder(dataset);
+  ARROW_RETURN_NOT_OK(scanner_builder.UseThreads(true));
+  ARROW_RETURN_NOT_OK(scanner_builder.Project(columns));
+  ARROW_RETURN_NOT_OK(scanner_builder.FragmentScanOptions(parquet_options));
+  ARROW_RETURN_NOT_OK(scanner_builder.FragmentReadahead(settings.fragment_readahead));
+  return scanner_builder.Finish();
+}
+
+arrow::Status TuneRemoteScan() {
+  std::shared_ptr<arrow::fs::FileSystem> fs =
+      std::make_shared<arrow::fs::LocalFileSystem>();
+  ARROW_ASSIGN_OR_RAISE(std::unique_ptr<arrow::internal::TemporaryDir> temp_dir,
+                        arrow::internal::TemporaryDir::Make("cookbook_cpp_airquality_"));
+  std::string base_dir = TemporaryDirPath(temp_dir.get());
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Table> table,
+                        MakeWideAirQuality(/*num_stations=*/4,
+                                           /*rows_per_station=*/1000,
+                                           /*num_sensors=*/16));
+  ARROW_RETURN_NOT_OK(WriteWideAirQuality(table, fs, base_dir, /*rows_per_file=*/2000,
+                                          /*rows_per_group=*/1000));
+
+  StartRecipe("TuningRemoteScans");
+  constexpr double kLatencySeconds = 0.01;
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::dataset::Dataset> dataset,
+                        OpenWithLatency(fs, base_dir, kLatencySeconds));
+  // Read every other sensor, leaving gaps between the column chunks we need
+  std::vector<std::string> columns = {"Station", "Temp"};
+  for (int sensor = 0; sensor < 16; sensor += 2) {
+    columns.push_back("Sensor" + std::to_string(sensor));
+  }
+  RemoteScanSettings settings =
+      RemoteScanSettingsFor(kLatencySeconds, /*bandwidth_mib_per_sec=*/100);
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::dataset::Scanner> scanner,
+                        MakeRemoteScanner(dataset, columns, settings));
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Table> scanned, scanner->ToTable());
+  rout << "Settings derived for a latency of " << kLatencySeconds * 1000
+       << "ms:" << std::endl;
+  rout << settings << std::endl;
+  rout << "Read " << scanned->num_rows() << " rows of " << scanned->num_columns()
+       << " columns" << std::endl;
+  EndRecipe("TuningRemoteScans");
+
+  EXPECT_EQ(scanned->num_rows(), table->num_rows());
+  EXPECT_EQ(scanned->num_columns(), static_cast<int>(columns.size()));
+  return arrow::Status::OK();
+}
+
 TEST_F(DatasetReadingTest, TestDatasetRead) {
   ASSERT_OK(DatasetRead(airquality_basedir()));
 }
+
+TEST_F(DatasetReadingTest, TestDatasetReadFromMetadata) {
+  ASSERT_OK(DatasetReadFromMetadata(airquality_basedir()));
+}
+
+TEST_F(DatasetReadingTest, TestCompareDatasetWriters) {
+  ASSERT_OK(CompareDatasetWriters(airquality()));
+}
+
+TEST_F(DatasetReadingTest, TestScanWithMemoryBudget) {
+  ASSERT_OK(ScanLargeDatasetWithBudget(airquality()));
+}
+
+TEST_F(DatasetReadingTest, TestScanPartitionedWithMemoryBudget) {
+  ASSERT_OK(ScanPartitionedDatasetWithBudget(airquality_basedir()));
+}
+
+TEST_F(DatasetReadingTest, TestCompareClusteredWrites) {
+  ASSERT_OK(CompareClusteredWrites(airquality()));
+}
+
+TEST_F(DatasetReadingTest, TestCompareIndexedLookups) {
+  ASSERT_OK(CompareIndexedLookups(airquality()));
+}
+
+TEST_F(DatasetReadingTest, TestLookupIndexValidation) {
+  ASSERT_OK(CheckLookupIndexValidation());
+}
+
+TEST_F(DatasetReadingTest, TestLateMaterialization) {
+  ASSERT_OK(CompareLateMaterialization());
+}
+
+TEST_F(DatasetReadingTest, TestCompareStorageFormats) {
+  ASSERT_OK(CompareStorageFormats());
+}
+
+TEST_F(DatasetReadingTest, TestTuneRemoteScan) {
+  ASSERT_OK(TuneRemoteScan());
+}
@@ -0,0 +1,139 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef ARROW_COOKBOOK_DATASETS_H
+#define ARROW_COOKBOOK_DATASETS_H
+
+// Code from datasets.cc that datasets_benchmark.cc measures
+
+#include <arrow/api.h>
+#include <arrow/dataset/api.h>
+#include <arrow/filesystem/api.h>
+
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/// \brief Write options for the airquality data, partitioned by Month and Day
+arrow::Result<arrow::dataset::FileSystemDatasetWriteOptions> MakeAirQualityWriteOptions(
+    std::shared_ptr<arrow::fs::FileSystem> fs, const std::string& base_dir);
+
+/// \brief Open a dataset written with MakeAirQualityWriteOptions, from its _metadata
+/// file if it has one
+arrow::Result<std::shared_ptr<arrow::dataset::Dataset>> OpenPartitionedDataset(
+    const std::shared_ptr<arrow::fs::FileSystem>& fs, const std::string& base_dir);
+
+/// \brief Size the row groups and files written with `options`, based on the row
+/// size of `sample`
+arrow::Status ConfigureSizedWrite(
+    const arrow::Table& sample, int64_t target_row_group_bytes, int64_t target_file_bytes,
+    uint32_t max_open_files, arrow::dataset::FileSystemDatasetWriteOptions* options);
+
+/// \brief Write `table` with `write_options`, delivered in small batches
+arrow::Status WriteInSmallBatches(
+    const std::shared_ptr<arrow::Table>& table,
+    const arrow::dataset::FileSystemDatasetWriteOptions& write_options);
+
+/// Row groups to read, keyed by file path relative to the dataset directory
+using RowGroupSelection = std::unordered_map<std::string, std::vector<int>>;
+
+/// \brief A sidecar index with min/max and a bloom filter for each row group
+class LookupIndex;
+
+/// \brief Write `table` as a dataset with small row groups and a sidecar index on
+/// Ozone and Temp
+arrow::Status WriteIndexedAirQuality(const std::shared_ptr<arrow::Table>& table,
+                                     const std::shared_ptr<arrow::fs::FileSystem>& fs,
+                                     const std::string& base_dir);
+
+/// \brief Load the sidecar index written by WriteIndexedAirQuality
+arrow::Result<std::shared_ptr<LookupIndex>> OpenLookupIndex(arrow::fs::FileSystem* fs,
+                                                            const std::string& base_dir);
+
+/// \brief Count the rows of `dataset` that match `filter`
+arrow::Result<int64_t> CountRowsMatching(
+    const std::shared_ptr<arrow::dataset::Dataset>& dataset,
+    const arrow::compute::Expression& filter);
+
+/// \brief Count the rows where `column` equals `value`, reading only the row groups
+/// that `index` selects
+arrow::Result<int64_t> CountRowsWithIndex(
+    const std::shared_ptr<arrow::dataset::Dataset>& dataset, const std::string& base_dir,
+    const LookupIndex& index, const std::string& column, double value);
+
+/// \brief Create a wide airquality-like table with readings from many stations
+arrow::Result<std::shared_ptr<arrow::Table>> MakeWideAirQuality(int num_stations,
+                                                                int rows_per_station,
+                                                                int num_sensors);
+
+/// \brief One way of storing a dataset on disk
+struct StorageFormat {
+  std::string name;
+  std::shared_ptr<arrow::dataset::FileWriteOptions> write_options;
+};
+
+/// \brief The formats and codecs worth comparing
+arrow::Result<std::vector<StorageFormat>> MakeStorageFormats();
+
+/// \brief Write `table` in the given format and open the result as a dataset
+arrow::Result<std::shared_ptr<arrow::dataset::Dataset>> WriteStorageFormat(
+    const std::shared_ptr<arrow::fs::FileSystem>& fs, const std::string& base_dir,
+    const std::shared_ptr<arrow::Table>& table,
+    const std::shared_ptr<arrow::dataset::Partitioning>& partitioning,
+    const StorageFormat& format);
+
+/// \brief Write `table` as parquet files of `rows_per_file` rows each
+arrow::Status WriteWideAirQuality(const std::shared_ptr<arrow::Table>& table,
+                                  const std::shared_ptr<arrow::fs::FileSystem>& fs,
+                                  const std::string& base_dir, int64_t rows_per_file,
+                                  int64_t rows_per_group);
+
+/// \brief The settings that control how a scan talks to the filesystem
+struct RemoteScanSettings {
+  /// Read all of the column chunks needed from a file up front, coalescing
+  /// nearby ranges, instead of issuing one read per column chunk
+  bool pre_buffer = true;
+  /// How ranges are coalesced, only used if pre_buffer is true
+  arrow::io::CacheOptions cache_options = arrow::io::CacheOptions::LazyDefaults();
+  /// How many files to read at the same time
+  int32_t fragment_readahead = arrow::dataset::kDefaultFragmentReadahead;
+};
+
+std::ostream& operator<<(std::ostream& os, const RemoteScanSettings& settings);
+
+/// \brief Settings derived from the latency and bandwidth of a filesystem
+///
+/// A starting point from a cost model, not a measured optimum.
+RemoteScanSettings RemoteScanSettingsFor(double latency_seconds,
+                                         int64_t bandwidth_mib_per_sec);
+
+/// \brief Open a parquet dataset through a filesystem that adds a delay of about
+/// `latency_seconds` to every call and every read
+arrow::Result<std::shared_ptr<arrow::dataset::Dataset>> OpenWithLatency(
+    const std::shared_ptr<arrow::fs::FileSystem>& fs, const std::string& base_dir,
+    double latency_seconds);
+
+/// \brief Create a scanner for `columns` of a parquet dataset that reads with the
+/// given settings
+arrow::Result<std::shared_ptr<arrow::dataset::Scanner>> MakeRemoteScanner(
+    const std::shared_ptr<arrow::dataset::Dataset>& dataset,
+    const std::vector<std::string>& columns, const RemoteScanSettings& settings);
+
+#endif  // ARROW_COOKBOOK_DATASETS_H
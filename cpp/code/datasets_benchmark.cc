@@ -0,0 +1,324 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <benchmark/benchmark.h>
+
+#include <arrow/api.h>
+#include <arrow/dataset/api.h>
+#include <arrow/filesystem/api.h>
+#include <arrow/util/byte_size.h>
+#include <parquet/arrow/reader.h>
+
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "benchmark_common.h"
+#include "common.h"
+#include "datasets.h"
+
+// Benchmarks for the recipes in datasets.cc
+
+namespace {
+
+/// \brief The air quality test data, repeated `copies` times
+arrow::Result<std::shared_ptr<arrow::Table>> ReadAirQuality(int copies) {
+  ARROW_ASSIGN_OR_RAISE(std::string path, FindTestDataFile("airquality.parquet"));
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::io::RandomAccessFile> input,
+                        arrow::io::ReadableFile::Open(path));
+  ARROW_ASSIGN_OR_RAISE(
+      std::unique_ptr<parquet::arrow::FileReader> reader,
+      parquet::arrow::OpenFile(std::move(input), arrow::default_memory_pool()));
+  std::shared_ptr<arrow::Table> table;
+#if ARROW_VERSION_MAJOR >= 24
+  ARROW_ASSIGN_OR_RAISE(table, reader->ReadTable());
+#else
+  ARROW_RETURN_NOT_OK(reader->ReadTable(&table));
+#endif
+  std::vector<std::shared_ptr<arrow::Table>> repeated(copies, table);
+  return arrow::ConcatenateTables(repeated);
+}
+
+/// \brief A scratch directory for `name`, in the system's temporary directory
+std::string BenchmarkDir(const std::string& name) {
+  return std::filesystem::temp_directory_path() / ("cookbook_cpp_benchmark_" + name);
+}
+
+/// \brief Write options for the air quality data, sized with ConfigureSizedWrite if
+/// `sized` is true
+arrow::Result<arrow::dataset::FileSystemDatasetWriteOptions> MakeWriteOptions(
+    const arrow::Table& table, bool sized, const std::string& base_dir) {
+  std::shared_ptr<arrow::fs::FileSystem> fs =
+      std::make_shared<arrow::fs::LocalFileSystem>();
+  ARROW_ASSIGN_OR_RAISE(arrow::dataset::FileSystemDatasetWriteOptions write_options,
+                        MakeAirQualityWriteOptions(fs, base_dir));
+  if (sized) {
+    ARROW_RETURN_NOT_OK(ConfigureSizedWrite(table, /*target_row_group_bytes=*/1 << 20,
+                                            /*target_file_bytes=*/64 << 20,
+                                            /*max_open_files=*/256, &write_options));
+  }
+  return write_options;
+}
+
+/// \brief Write the air quality data in small batches, with the default writer
+/// options or with sized ones
+arrow::Status WriteDataset(benchmark::State& state, bool sized) {
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Table> table, ReadAirQuality(20));
+  ARROW_ASSIGN_OR_RAISE(
+      arrow::dataset::FileSystemDatasetWriteOptions write_options,
+      MakeWriteOptions(*table, sized, BenchmarkDir(sized ? "sized" : "default")));
+  for (auto _ : state) {
+    ARROW_RETURN_NOT_OK(WriteInSmallBatches(table, write_options));
+  }
+  state.SetItemsProcessed(state.iterations() * table->num_rows());
+  return arrow::Status::OK();
+}
+
+/// \brief Scan the air quality data after writing it in small batches, with the
+/// default writer options or with sized ones
+arrow::Status ScanDataset(benchmark::State& state, bool sized) {
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Table> table, ReadAirQuality(20));
+  ARROW_ASSIGN_OR_RAISE(
+      arrow::dataset::FileSystemDatasetWriteOptions write_options,
+      MakeWriteOptions(*table, sized, BenchmarkDir(sized ? "sized" : "default")));
+  ARROW_RETURN_NOT_OK(WriteInSmallBatches(table, write_options));
+  for (auto _ : state) {
+    ARROW_ASSIGN_OR_RAISE(
+        std::shared_ptr<arrow::dataset::Dataset> dataset,
+        OpenPartitionedDataset(write_options.filesystem, write_options.base_dir));
+    ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::dataset::ScannerBuilder> builder,
+                          dataset->NewScan());
+    ARROW_RETURN_NOT_OK(builder->UseThreads(true));
+    ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::dataset::Scanner> scanner,
+                          builder->Finish());
+    ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Table> scanned, scanner->ToTable());
+    benchmark::DoNotOptimize(scanned);
+  }
+  state.SetItemsProcessed(state.iterations() * table->num_rows());
+  return arrow::Status::OK();
+}
+
+/// \brief Write the air quality data with a sidecar index, to be looked up with or
+/// without it
+arrow::Result<std::string> WriteIndexedDataset() {
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Table> table, ReadAirQuality(100));
+  std::string base_dir = BenchmarkDir("indexed");
+  ARROW_RETURN_NOT_OK(WriteIndexedAirQuality(
+      table, std::make_shared<arrow::fs::LocalFileSystem>(), base_dir));
+  return base_dir;
+}
+
+/// \brief Look up one Ozone value, starting from dataset discovery, by scanning every
+/// row group that min/max statistics can't rule out or by consulting the index first
+arrow::Status LookupValue(benchmark::State& state, bool use_index) {
+  ARROW_ASSIGN_OR_RAISE(std::string base_dir, WriteIndexedDataset());
+  std::shared_ptr<arrow::fs::FileSystem> fs =
+      std::make_shared<arrow::fs::LocalFileSystem>();
+  // Like a long-running service, load the index once and use it for every lookup
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<LookupIndex> index,
+                        OpenLookupIndex(fs.get(), base_dir));
+  constexpr double kOzone = 135;
+  arrow::compute::Expression filter = arrow::compute::equal(
+      arrow::compute::field_ref("Ozone"), arrow::compute::literal(kOzone));
+  for (auto _ : state) {
+    ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::dataset::Dataset> dataset,
+                          OpenPartitionedDataset(fs, base_dir));
+    int64_t num_rows = 0;
+    if (use_index) {
+      ARROW_ASSIGN_OR_RAISE(
+          num_rows, CountRowsWithIndex(dataset, base_dir, *index, "Ozone", kOzone));
+    } else {
+      ARROW_ASSIGN_OR_RAISE(num_rows, CountRowsMatching(dataset, filter));
+    }
+    benchmark::DoNotOptimize(num_rows);
+  }
+  return arrow::Status::OK();
+}
+
+/// \brief Sensor readings from 20 stations, partitioned by station
+struct WideAirQuality {
+  std::shared_ptr<arrow::Table> table;
+  std::shared_ptr<arrow::dataset::Partitioning> partitioning;
+};
+
+arrow::Result<WideAirQuality> MakeWideAirQualityData() {
+  WideAirQuality data;
+  ARROW_ASSIGN_OR_RAISE(data.table, MakeWideAirQuality(/*num_stations=*/20,
+                                                       /*rows_per_station=*/5000,
+                                                       /*num_sensors=*/4));
+  data.partitioning = std::make_shared<arrow::dataset::HivePartitioning>(
+      arrow::schema({arrow::field("Station", arrow::utf8())}));
+  return data;
+}
+
+/// \brief Write the wide air quality data in `format`
+arrow::Status WriteStorageFormatBenchmark(benchmark::State& state,
+                                          const StorageFormat& format) {
+  ARROW_ASSIGN_OR_RAISE(WideAirQuality data, MakeWideAirQualityData());
+  std::shared_ptr<arrow::fs::FileSystem> fs =
+      std::make_shared<arrow::fs::LocalFileSystem>();
+  for (auto _ : state) {
+    ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::dataset::Dataset> dataset,
+                          WriteStorageFormat(fs, BenchmarkDir("formats"), data.table,
+                                             data.partitioning, format));
+    benchmark::DoNotOptimize(dataset);
+  }
+  // Throughput is measured against the size of the data in memory
+  state.SetBytesProcessed(state.iterations() *
+                          arrow::util::TotalBufferSize(*data.table));
+  return arrow::Status::OK();
+}
+
+/// \brief Scan the wide air quality data stored in `format`, either every column or
+/// only `projected_column`
+arrow::Status ScanStorageFormatBenchmark(benchmark::State& state,
+                                         const StorageFormat& format,
+                                         const std::string& projected_column) {
+  ARROW_ASSIGN_OR_RAISE(WideAirQuality data, MakeWideAirQualityData());
+  std::shared_ptr<arrow::fs::FileSystem> fs =
+      std::make_shared<arrow::fs::LocalFileSystem>();
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::dataset::Dataset> dataset,
+                        WriteStorageFormat(fs, BenchmarkDir("formats"), data.table,
+                                           data.partitioning, format));
+  for (auto _ : state) {
+    ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::dataset::ScannerBuilder> scan_builder,
+                          dataset->NewScan());
+    if (!projected_column.empty()) {
+      ARROW_RETURN_NOT_OK(scan_builder->Project({projected_column}));
+    }
+    ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::dataset::Scanner> scanner,
+                          scan_builder->Finish());
+    ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Table> scanned, scanner->ToTable());
+    benchmark::DoNotOptimize(scanned);
+  }
+  int64_t bytes = projected_column.empty()
+                      ? arrow::util::TotalBufferSize(*data.table)
+                      : arrow::util::TotalBufferSize(
+                            *data.table->GetColumnByName(projected_column));
+  state.SetBytesProcessed(state.iterations() * bytes);
+  return arrow::Status::OK();
+}
+
+/// \brief Scan every other sensor of the wide air quality data through a filesystem
+/// with a latency of 10ms, using the given settings
+arrow::Status RemoteScan(benchmark::State& state, const RemoteScanSettings& settings) {
+  std::shared_ptr<arrow::fs::FileSystem> fs =
+      std::make_shared<arrow::fs::LocalFileSystem>();
+  std::string base_dir = BenchmarkDir("remote");
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Table> table,
+                        MakeWideAirQuality(/*num_stations=*/20,
+                                           /*rows_per_station=*/5000,
+                                           /*num_sensors=*/16));
+  ARROW_RETURN_NOT_OK(WriteWideAirQuality(table, fs, base_dir, /*rows_per_file=*/25000,
+                                          /*rows_per_group=*/5000));
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::dataset::Dataset> dataset,
+                        OpenWithLatency(fs, base_dir, /*latency_seconds=*/0.01));
+  std::vector<std::string> columns = {"Station", "Temp"};
+  for (int sensor = 0; sensor < 16; sensor += 2) {
+    columns.push_back("Sensor" + std::to_string(sensor));
+  }
+  for (auto _ : state) {
+    ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::dataset::Scanner> scanner,
+                          MakeRemoteScanner(dataset, columns, settings));
+    ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Table> scanned, scanner->ToTable());
+    benchmark::DoNotOptimize(scanned);
+  }
+  return arrow::Status::OK();
+}
+
+int RegisterRemoteScanBenchmarks() {
+  std::vector<std::pair<std::string, arrow::io::CacheOptions>> cache_candidates = {
+      {"lazy_defaults", arrow::io::CacheOptions::LazyDefaults()},
+      {"defaults", arrow::io::CacheOptions::Defaults()},
+      {"network_metrics",
+       RemoteScanSettingsFor(/*latency_seconds=*/0.01, /*bandwidth_mib_per_sec=*/100)
+           .cache_options},
+  };
+  for (int32_t fragment_readahead : {1, 4}) {
+    std::string readahead = "/readahead:" + std::to_string(fragment_readahead);
+    RemoteScanSettings settings;
+    settings.fragment_readahead = fragment_readahead;
+    settings.pre_buffer = false;
+    RegisterArrowBenchmark("RemoteScan/no_pre_buffer" + readahead, RemoteScan, settings)
+        ->Unit(benchmark::kMillisecond)
+        ->UseRealTime();
+    settings.pre_buffer = true;
+    for (const std::pair<std::string, arrow::io::CacheOptions>& candidate :
+         cache_candidates) {
+      settings.cache_options = candidate.second;
+      RegisterArrowBenchmark("RemoteScan/" + candidate.first + readahead, RemoteScan,
+                             settings)
+          ->Unit(benchmark::kMillisecond)
+          ->UseRealTime();
+    }
+  }
+  return 0;
+}
+
+int RegisterStorageFormatBenchmarks() {
+  arrow::Result<std::vector<StorageFormat>> formats = MakeStorageFormats();
+  if (!formats.ok()) {
+    std::cerr << "Cannot create the storage formats: " << formats.status().ToString()
+              << std::endl;
+    return 1;
+  }
+  for (const StorageFormat& format : *formats) {
+    RegisterArrowBenchmark("WriteStorageFormat/" + format.name,
+                           WriteStorageFormatBenchmark, format)
+        ->Unit(benchmark::kMillisecond)
+        ->UseRealTime();
+    RegisterArrowBenchmark("ScanStorageFormat/" + format.name + "/all",
+                           ScanStorageFormatBenchmark, format, std::string())
+        ->Unit(benchmark::kMillisecond)
+        ->UseRealTime();
+    RegisterArrowBenchmark("ScanStorageFormat/" + format.name + "/Temp",
+                           ScanStorageFormatBenchmark, format, std::string("Temp"))
+        ->Unit(benchmark::kMillisecond)
+        ->UseRealTime();
+  }
+  return 0;
+}
+
+int RegisterDatasetBenchmarks() {
+  for (bool sized : {false, true}) {
+    std::string writer = sized ? "sized" : "default";
+    RegisterArrowBenchmark("WriteDataset/" + writer, WriteDataset, sized)
+        ->Unit(benchmark::kMillisecond)
+        ->UseRealTime();
+    RegisterArrowBenchmark("ScanDataset/" + writer, ScanDataset, sized)
+        ->Unit(benchmark::kMillisecond)
+        ->UseRealTime();
+  }
+  for (bool use_index : {false, true}) {
+    RegisterArrowBenchmark(use_index ? "LookupValue/index" : "LookupValue/statistics",
+                           LookupValue, use_index)
+        ->Unit(benchmark::kMillisecond)
+        ->UseRealTime();
+  }
+  return 0;
+}
+
+[[maybe_unused]] const int kDatasetBenchmarksRegistered = RegisterDatasetBenchmarks();
+[[maybe_unused]] const int kStorageFormatBenchmarksRegistered =
+    RegisterStorageFormatBenchmarks();
+[[maybe_unused]] const int kRemoteScanBenchmarksRegistered =
+    RegisterRemoteScanBenchmarks();
+
+}  // namespace
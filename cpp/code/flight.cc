@@ -20,6 +20,7 @@
 #include <arrow/filesystem/localfs.h>
 #include <arrow/flight/client.h>
 #include <arrow/flight/server.h>
+#include <arrow/io/file.h>
 #include <arrow/pretty_print.h>
 #include <arrow/result.h>
 #include <arrow/status.h>
@@ -34,11 +35,18 @@
 #include <protos/helloworld.pb.h>
 
 #include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <numeric>
+#include <string>
+#include <utility>
 #include <vector>
 
 #include "common.h"
+#include "flight.h"
 
 class ParquetStorageService : public arrow::flight::FlightServerBase {
  public:
@@ -135,7 +143,16 @@ class ParquetStorageService : public arrow::flight::FlightServerBase {
     return arrow::Status::NotImplemented("Unknown action type: ", action.type);
   }
 
- private:
+ protected:
+  /// \brief Where clients can fetch a dataset from, by default only this server
+  virtual arrow::Result<std::vector<arrow::flight::Location>> DatasetLocations(
+      const std::string&) {
+    arrow::flight::Location location;
+    ARROW_ASSIGN_OR_RAISE(location,
+                          arrow::flight::Location::ForGrpcTcp("localhost", port()));
+    return std::vector<arrow::flight::Location>{location};
+  }
+
   arrow::Result<arrow::flight::FlightInfo> MakeFlightInfo(
       const arrow::fs::FileInfo& file_info) {
     ARROW_ASSIGN_OR_RAISE(auto input, root_->OpenInputFile(file_info));
@@ -150,10 +167,7 @@ class ParquetStorageService : public arrow::flight::FlightServerBase {
 
     arrow::flight::FlightEndpoint endpoint;
     endpoint.ticket.ticket = file_info.base_name();
-    arrow::flight::Location location;
-    ARROW_ASSIGN_OR_RAISE(location,
-                          arrow::flight::Location::ForGrpcTcp("localhost", port()));
-    endpoint.locations.push_back(location);
+    ARROW_ASSIGN_OR_RAISE(endpoint.locations, DatasetLocations(file_info.base_name()));
 
     int64_t total_records = reader->parquet_reader()->metadata()->num_rows();
     int64_t total_bytes = file_info.size();
@@ -180,6 +194,383 @@ class ParquetStorageService : public arrow::flight::FlightServerBase {
   std::shared_ptr<arrow::fs::FileSystem> root_;
 };  // end ParquetStorageService
 
+/// \brief Assigns keys to the members of a cluster by consistent hashing
+///
+/// Every member is placed at several points ("virtual nodes") on a ring of 64-bit
+/// hashes, and a key belongs to the first members found walking clockwise from the
+/// hash of the key.  Adding a member only moves the keys next to its points instead
+/// of reshuffling every key.
+class ConsistentHashRing {
+ public:
+  explicit ConsistentHashRing(size_t num_members, int virtual_nodes = 64)
+      : num_members_(num_members) {
+    for (size_t member = 0; member < num_members; member++) {
+      for (int node = 0; node < virtual_nodes; node++) {
+        std::string name =
+            "member-" + std::to_string(member) + "#" + std::to_string(node);
+        ring_.emplace_back(Hash(name), member);
+      }
+    }
+    std::sort(ring_.begin(), ring_.end());
+  }
+
+  /// \brief The first `count` distinct members that own `key`, primary owner first
+  std::vector<size_t> Owners(const std::string& key, size_t count) const {
+    count = std::min(count, num_members_);
+    std::vector<size_t> owners;
+    std::vector<std::pair<uint64_t, size_t>>::const_iterator it = std::lower_bound(
+        ring_.begin(), ring_.end(), std::make_pair(Hash(key), size_t{0}));
+    while (owners.size() < count) {
+      if (it == ring_.end()) it = ring_.begin();
+      if (std::find(owners.begin(), owners.end(), it->second) == owners.end()) {
+        owners.push_back(it->second);
+      }
+      ++it;
+    }
+    return owners;
+  }
+
+ private:
+  // FNV-1a followed by a finalizer to spread similar keys out.  Unlike std::hash,
+  // this gives the same value in every process.
+  static uint64_t Hash(const std::string& value) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (char c : value) {
+      hash = (hash ^ static_cast<uint8_t>(c)) * 1099511628211ULL;
+    }
+    hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebULL;
+    return hash ^ (hash >> 31);
+  }
+
+  size_t num_members_;
+  std::vector<std::pair<uint64_t, size_t>> ring_;
+};  // ConsistentHashRing
+
+/// \brief Upload a table to a Flight service under the given name
+arrow::Status PutTable(arrow::flight::FlightClient* client,
+                       const arrow::flight::FlightCallOptions& options,
+                       const std::string& name, const arrow::Table& table) {
+  arrow::flight::FlightDescriptor descriptor =
+      arrow::flight::FlightDescriptor::Path({name});
+  ARROW_ASSIGN_OR_RAISE(arrow::flight::FlightClient::DoPutResult put,
+                        client->DoPut(options, descriptor, table.schema()));
+  ARROW_RETURN_NOT_OK(put.writer->WriteTable(table));
+  return put.writer->Close();
+}
+
+/// \brief A ParquetStorageService that is one member of a cluster
+///
+/// Every member is given the same list of member locations, and each dataset is
+/// stored on the member that owns its name plus `num_replicas` more members.  Any
+/// member accepts uploads and describes any dataset, and the endpoints it returns
+/// point clients at the members that store the data.
+class ShardedParquetStorageService : public ParquetStorageService {
+ public:
+  explicit ShardedParquetStorageService(std::shared_ptr<arrow::fs::FileSystem> root,
+                                        int num_replicas = 0)
+      : ParquetStorageService(std::move(root)), num_replicas_(num_replicas) {}
+
+  /// \brief Sent as application metadata by an uploader that gives up halfway, so
+  /// the members discard what they have received instead of storing part of a dataset
+  static constexpr char kAbortUpload[] = "abort_upload";
+
+  /// \brief Set the members of the cluster, with this server at index `self`
+  ///
+  /// Must be called before the server receives any requests.
+  arrow::Status SetMembers(std::vector<arrow::flight::Location> members, size_t self) {
+    if (self >= members.size()) {
+      return arrow::Status::Invalid("Member index ", self, " is out of range for ",
+                                    members.size(), " members");
+    }
+    members_ = std::move(members);
+    self_ = self;
+    ring_ = std::make_unique<ConsistentHashRing>(members_.size());
+    peers_.resize(members_.size());
+    return arrow::Status::OK();
+  }
+
+  arrow::Status ListFlights(
+      const arrow::flight::ServerCallContext& context,
+      const arrow::flight::Criteria* criteria,
+      std::unique_ptr<arrow::flight::FlightListing>* listings) override {
+    // Every member lists the datasets it is the primary owner of, so replicas are
+    // only listed once.  The member the client asked collects them all.
+    std::unique_ptr<arrow::flight::FlightListing> local;
+    ARROW_RETURN_NOT_OK(ParquetStorageService::ListFlights(context, criteria, &local));
+    std::vector<arrow::flight::FlightInfo> flights;
+    while (true) {
+      ARROW_ASSIGN_OR_RAISE(std::unique_ptr<arrow::flight::FlightInfo> info,
+                            local->Next());
+      if (!info) break;
+      ARROW_ASSIGN_OR_RAISE(std::vector<size_t> owners,
+                            Owners(info->descriptor().path[0]));
+      if (owners[0] == self_) flights.push_back(std::move(*info));
+    }
+    if (!IsForwarded(context)) {
+      for (size_t member = 0; member < members_.size(); member++) {
+        if (member == self_) continue;
+        ARROW_ASSIGN_OR_RAISE(arrow::flight::FlightClient * peer, Peer(member));
+        ARROW_ASSIGN_OR_RAISE(std::unique_ptr<arrow::flight::FlightListing> listing,
+                              peer->ListFlights(ForwardedCallOptions(), {}));
+        while (true) {
+          ARROW_ASSIGN_OR_RAISE(std::unique_ptr<arrow::flight::FlightInfo> info,
+                                listing->Next());
+          if (!info) break;
+          flights.push_back(std::move(*info));
+        }
+      }
+    }
+    *listings = std::unique_ptr<arrow::flight::FlightListing>(
+        new arrow::flight::SimpleFlightListing(std::move(flights)));
+    return arrow::Status::OK();
+  }
+
+  arrow::Status GetFlightInfo(const arrow::flight::ServerCallContext& context,
+                              const arrow::flight::FlightDescriptor& descriptor,
+                              std::unique_ptr<arrow::flight::FlightInfo>* info) override {
+    ARROW_ASSIGN_OR_RAISE(std::vector<size_t> owners, OwnersOf(descriptor));
+    if (std::find(owners.begin(), owners.end(), self_) != owners.end()) {
+      return ParquetStorageService::GetFlightInfo(context, descriptor, info);
+    }
+    // Only the owners have the file to read the schema and row count from
+    ARROW_ASSIGN_OR_RAISE(arrow::flight::FlightClient * peer, Peer(owners[0]));
+    ARROW_ASSIGN_OR_RAISE(*info, peer->GetFlightInfo(ForwardedCallOptions(), descriptor));
+    return arrow::Status::OK();
+  }
+
+  arrow::Status DoPut(const arrow::flight::ServerCallContext& context,
+                      std::unique_ptr<arrow::flight::FlightMessageReader> reader,
+                      std::unique_ptr<arrow::flight::FlightMetadataWriter>) override {
+    arrow::flight::FlightDescriptor descriptor = reader->descriptor();
+    // Another member may have already routed this upload here
+    std::vector<size_t> owners = {self_};
+    if (!IsForwarded(context)) {
+      ARROW_ASSIGN_OR_RAISE(owners, OwnersOf(descriptor));
+    }
+    ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Schema> schema, reader->GetSchema());
+
+    // Pass each batch on to every owner as it arrives, so a member never holds a
+    // whole upload in memory.  The local copy is written under a temporary name that
+    // is not listed, and only renamed once every owner has the whole upload.
+    std::string path;
+    std::string temp_path;
+    std::unique_ptr<parquet::arrow::FileWriter> file_writer;
+    std::vector<arrow::flight::FlightClient::DoPutResult> peer_puts;
+    arrow::Status status = [&]() -> arrow::Status {
+      for (size_t owner : owners) {
+        if (owner == self_) {
+          ARROW_ASSIGN_OR_RAISE(arrow::fs::FileInfo file_info,
+                                FileInfoFromDescriptor(descriptor));
+          path = file_info.path();
+          temp_path = path + ".upload-" + std::to_string(next_upload_id_++);
+          ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::io::OutputStream> sink,
+                                root_->OpenOutputStream(temp_path));
+          std::shared_ptr<parquet::WriterProperties> properties =
+              parquet::WriterProperties::Builder().max_row_group_length(65536)->build();
+          ARROW_ASSIGN_OR_RAISE(
+              file_writer, parquet::arrow::FileWriter::Open(
+                               *schema, arrow::default_memory_pool(), std::move(sink),
+                               std::move(properties)));
+        } else {
+          ARROW_ASSIGN_OR_RAISE(arrow::flight::FlightClient * peer, Peer(owner));
+          ARROW_ASSIGN_OR_RAISE(arrow::flight::FlightClient::DoPutResult put,
+                                peer->DoPut(ForwardedCallOptions(), descriptor, schema));
+          peer_puts.push_back(std::move(put));
+        }
+      }
+      while (true) {
+        ARROW_ASSIGN_OR_RAISE(arrow::flight::FlightStreamChunk chunk, reader->Next());
+        if (!chunk.data) {
+          if (chunk.app_metadata && chunk.app_metadata->ToString() == kAbortUpload) {
+            return arrow::Status::Cancelled("The upload was aborted by the sender");
+          }
+          if (chunk.app_metadata) continue;
+          break;
+        }
+        if (file_writer) {
+          ARROW_RETURN_NOT_OK(file_writer->WriteRecordBatch(*chunk.data));
+        }
+        for (arrow::flight::FlightClient::DoPutResult& put : peer_puts) {
+          ARROW_RETURN_NOT_OK(put.writer->WriteRecordBatch(*chunk.data));
+        }
+      }
+      if (file_writer) {
+        ARROW_RETURN_NOT_OK(file_writer->Close());
+      }
+      while (!peer_puts.empty()) {
+        ARROW_RETURN_NOT_OK(peer_puts.back().writer->Close());
+        peer_puts.pop_back();
+      }
+      if (!temp_path.empty()) {
+        ARROW_RETURN_NOT_OK(root_->Move(temp_path, path));
+      }
+      return arrow::Status::OK();
+    }();
+    if (!status.ok()) {
+      // Leave no partial copy behind, here or on the other owners
+      for (arrow::flight::FlightClient::DoPutResult& put : peer_puts) {
+        ARROW_UNUSED(put.writer->WriteMetadata(arrow::Buffer::FromString(kAbortUpload)));
+        ARROW_UNUSED(put.writer->Close());
+      }
+      if (file_writer) {
+        ARROW_UNUSED(file_writer->Close());
+      }
+      if (!temp_path.empty()) {
+        ARROW_UNUSED(root_->DeleteFile(temp_path));
+      }
+    }
+    return status;
+  }
+
+  arrow::Status DoAction(const arrow::flight::ServerCallContext& context,
+                         const arrow::flight::Action& action,
+                         std::unique_ptr<arrow::flight::ResultStream>* result) override {
+    if (action.type != kActionDropDataset.type || IsForwarded(context)) {
+      return ParquetStorageService::DoAction(context, action, result);
+    }
+    // Drop every copy of the dataset
+    std::string name = action.body->ToString();
+    ARROW_ASSIGN_OR_RAISE(std::vector<size_t> owners, Owners(name));
+    for (size_t owner : owners) {
+      if (owner == self_) {
+        ARROW_RETURN_NOT_OK(ParquetStorageService::DoAction(context, action, result));
+      } else {
+        ARROW_ASSIGN_OR_RAISE(arrow::flight::FlightClient * peer, Peer(owner));
+        ARROW_ASSIGN_OR_RAISE(std::unique_ptr<arrow::flight::ResultStream> results,
+                              peer->DoAction(ForwardedCallOptions(), action));
+        ARROW_RETURN_NOT_OK(results->Drain());
+      }
+    }
+    *result = std::unique_ptr<arrow::flight::ResultStream>(
+        new arrow::flight::SimpleResultStream({}));
+    return arrow::Status::OK();
+  }
+
+ protected:
+  arrow::Result<std::vector<arrow::flight::Location>> DatasetLocations(
+      const std::string& name) override {
+    ARROW_ASSIGN_OR_RAISE(std::vector<size_t> owners, Owners(name));
+    std::vector<arrow::flight::Location> locations;
+    for (size_t owner : owners) {
+      locations.push_back(members_[owner]);
+    }
+    return locations;
+  }
+
+ private:
+  // Set on calls between members, so that they are handled locally instead of
+  // being routed again
+  static constexpr char kForwardedHeader[] = "x-cookbook-forwarded";
+
+  static bool IsForwarded(const arrow::flight::ServerCallContext& context) {
+    return context.incoming_headers().count(kForwardedHeader) > 0;
+  }
+
+  static arrow::flight::FlightCallOptions ForwardedCallOptions() {
+    arrow::flight::FlightCallOptions options;
+    options.headers.emplace_back(kForwardedHeader, "1");
+    return options;
+  }
+
+  arrow::Result<std::vector<size_t>> Owners(const std::string& name) const {
+    if (!ring_) {
+      return arrow::Status::Invalid("Cluster members have not been set");
+    }
+    return ring_->Owners(name, 1 + num_replicas_);
+  }
+
+  arrow::Result<std::vector<size_t>> OwnersOf(
+      const arrow::flight::FlightDescriptor& descriptor) {
+    // Validates the descriptor the same way as a standalone service
+    ARROW_RETURN_NOT_OK(FileInfoFromDescriptor(descriptor).status());
+    return Owners(descriptor.path[0]);
+  }
+
+  /// \brief A client for another member, connected the first time it is needed
+  arrow::Result<arrow::flight::FlightClient*> Peer(size_t member) {
+    std::lock_guard<std::mutex> lock(peers_mutex_);
+    if (!peers_[member]) {
+      ARROW_ASSIGN_OR_RAISE(peers_[member],
+                            arrow::flight::FlightClient::Connect(members_[member]));
+    }
+    return peers_[member].get();
+  }
+
+  const int num_replicas_;
+  std::vector<arrow::flight::Location> members_;
+  size_t self_ = 0;
+  std::unique_ptr<ConsistentHashRing> ring_;
+  std::mutex peers_mutex_;
+  std::vector<std::unique_ptr<arrow::flight::FlightClient>> peers_;
+  std::atomic<uint64_t> next_upload_id_{0};
+};  // end ShardedParquetStorageService
+
+LocalCluster::LocalCluster() = default;
+
+LocalCluster::LocalCluster(LocalCluster&&) = default;
+
+LocalCluster::~LocalCluster() {
+  ARROW_WARN_NOT_OK(Shutdown(), "Failed to shut down a local cluster");
+}
+
+int LocalCluster::MemberAt(const arrow::flight::Location& location) const {
+  for (size_t i = 0; i < locations.size(); i++) {
+    if (locations[i].Equals(location)) return static_cast<int>(i);
+  }
+  return -1;
+}
+
+arrow::Status LocalCluster::Shutdown() {
+  arrow::Status status;
+  for (std::unique_ptr<ShardedParquetStorageService>& member : members) {
+    status &= member->Shutdown();
+  }
+  members.clear();
+  return status;
+}
+
+/// \brief Start a cluster on localhost, each member storing datasets in its own
+/// directory under `base_dir`
+arrow::Result<LocalCluster> StartLocalCluster(const std::string& base_dir,
+                                              size_t num_members, int num_replicas) {
+  if (num_members == 0) {
+    return arrow::Status::Invalid("A cluster needs at least one member");
+  }
+  if (num_replicas < 0) {
+    return arrow::Status::Invalid("The number of replicas cannot be negative");
+  }
+  std::shared_ptr<arrow::fs::FileSystem> fs =
+      std::make_shared<arrow::fs::LocalFileSystem>();
+  LocalCluster cluster;
+  for (size_t i = 0; i < num_members; i++) {
+    std::string member_dir = base_dir + "/member_" + std::to_string(i) + "/";
+    ARROW_RETURN_NOT_OK(fs->CreateDir(member_dir));
+    ARROW_RETURN_NOT_OK(fs->DeleteDirContents(member_dir));
+    std::shared_ptr<arrow::fs::FileSystem> root =
+        std::make_shared<arrow::fs::SubTreeFileSystem>(member_dir, fs);
+
+    arrow::flight::Location server_location;
+    ARROW_ASSIGN_OR_RAISE(server_location,
+                          arrow::flight::Location::ForGrpcTcp("0.0.0.0", 0));
+    arrow::flight::FlightServerOptions options(server_location);
+    std::unique_ptr<ShardedParquetStorageService> member =
+        std::make_unique<ShardedParquetStorageService>(std::move(root), num_replicas);
+    ARROW_RETURN_NOT_OK(member->Init(options));
+
+    arrow::flight::Location location;
+    ARROW_ASSIGN_OR_RAISE(
+        location, arrow::flight::Location::ForGrpcTcp("localhost", member->port()));
+    cluster.locations.push_back(location);
+    cluster.members.push_back(std::move(member));
+  }
+  // Every member gets the same list, so they all agree on who owns which dataset
+  for (size_t i = 0; i < num_members; i++) {
+    ARROW_RETURN_NOT_OK(cluster.members[i]->SetMembers(cluster.locations, i));
+  }
+  return cluster;
+}
+
 class HelloWorldServiceImpl : public HelloWorldService::Service {
   grpc::Status SayHello(grpc::ServerContext*, const HelloRequest* request,
                         HelloResponse* reply) override {
@@ -313,9 +704,10 @@ arrow::Status TestPutGetDelete() {
 arrow::Status TestClientOptions() {
   // Set up server as usual
   auto fs = std::make_shared<arrow::fs::LocalFileSystem>();
-  ARROW_RETURN_NOT_OK(fs->CreateDir("./flight_datasets/"));
-  ARROW_RETURN_NOT_OK(fs->DeleteDirContents("./flight_datasets/"));
-  auto root = std::make_shared<arrow::fs::SubTreeFileSystem>("./flight_datasets/", fs);
+  ARROW_RETURN_NOT_OK(fs->CreateDir("./flight_datasets_client_options/"));
+  ARROW_RETURN_NOT_OK(fs->DeleteDirContents("./flight_datasets_client_options/"));
+  auto root = std::make_shared<arrow::fs::SubTreeFileSystem>(
+      "./flight_datasets_client_options/", fs);
 
   arrow::flight::Location server_location;
   ARROW_ASSIGN_OR_RAISE(server_location,
@@ -349,9 +741,10 @@ arrow::Status TestClientOptions() {
 arrow::Status TestCustomGrpcImpl() {
   // Build flight service as usual
   auto fs = std::make_shared<arrow::fs::LocalFileSystem>();
-  ARROW_RETURN_NOT_OK(fs->CreateDir("./flight_datasets/"));
-  ARROW_RETURN_NOT_OK(fs->DeleteDirContents("./flight_datasets/"));
-  auto root = std::make_shared<arrow::fs::SubTreeFileSystem>("./flight_datasets/", fs);
+  ARROW_RETURN_NOT_OK(fs->CreateDir("./flight_datasets_custom_grpc/"));
+  ARROW_RETURN_NOT_OK(fs->DeleteDirContents("./flight_datasets_custom_grpc/"));
+  auto root = std::make_shared<arrow::fs::SubTreeFileSystem>(
+      "./flight_datasets_custom_grpc/", fs);
 
   StartRecipe("CustomGrpcImpl::StartServer");
   arrow::flight::Location server_location;
@@ -402,6 +795,196 @@ arrow::Status TestCustomGrpcImpl() {
   return arrow::Status::OK();
 }
 
+arrow::Result<std::shared_ptr<arrow::Table>> ReadAirQuality() {
+  ARROW_ASSIGN_OR_RAISE(std::string airquality_path,
+                        FindTestDataFile("airquality.parquet"));
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::io::RandomAccessFile> input,
+                        arrow::io::ReadableFile::Open(airquality_path));
+  ARROW_ASSIGN_OR_RAISE(
+      std::unique_ptr<parquet::arrow::FileReader> reader,
+      parquet::arrow::OpenFile(std::move(input), arrow::default_memory_pool()));
+  std::shared_ptr<arrow::Table> table;
+#if ARROW_VERSION_MAJOR >= 24
+  ARROW_ASSIGN_OR_RAISE(table, reader->ReadTable());
+#else
+  ARROW_RETURN_NOT_OK(reader->ReadTable(&table));
+#endif
+  return table;
+}
+
+/// \brief Fetch every dataset from the members its endpoints point at, `rounds`
+/// times over starting at `infos[first]`, and return the total number of rows read
+arrow::Result<int64_t> FetchDatasets(
+    const std::vector<std::unique_ptr<arrow::flight::FlightInfo>>& infos, int rounds,
+    size_t first) {
+  // One connection per member, like a client fetching the parts of a query
+  std::map<std::string, std::unique_ptr<arrow::flight::FlightClient>> clients;
+  int64_t rows = 0;
+  for (int round = 0; round < rounds; round++) {
+    for (size_t i = 0; i < infos.size(); i++) {
+      const arrow::flight::FlightInfo& info = *infos[(first + i) % infos.size()];
+      for (const arrow::flight::FlightEndpoint& endpoint : info.endpoints()) {
+        // The first location is the primary owner, the rest are replicas
+        const arrow::flight::Location& location = endpoint.locations[0];
+        std::unique_ptr<arrow::flight::FlightClient>& client =
+            clients[location.ToString()];
+        if (!client) {
+          ARROW_ASSIGN_OR_RAISE(client, arrow::flight::FlightClient::Connect(location));
+        }
+        ARROW_ASSIGN_OR_RAISE(std::unique_ptr<arrow::flight::FlightStreamReader> stream,
+                              client->DoGet(endpoint.ticket));
+        ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Table> table, stream->ToTable());
+        rows += table->num_rows();
+      }
+    }
+  }
+  return rows;
+}
+
+arrow::Status TestShardedStorage() {
+  StartRecipe("ShardedParquetStorageService::StartCluster");
+  // Three members, each dataset stored on two of them
+  ARROW_ASSIGN_OR_RAISE(LocalCluster cluster,
+                        StartLocalCluster("./flight_cluster", /*num_members=*/3,
+                                          /*num_replicas=*/1));
+  rout << "Started " << cluster.members.size() << " members" << std::endl;
+  EndRecipe("ShardedParquetStorageService::StartCluster");
+
+  StartRecipe("ShardedParquetStorageService::DoPut");
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Table> airquality, ReadAirQuality());
+  // Upload everything through the first member, which routes each dataset to its
+  // owners
+  std::unique_ptr<arrow::flight::FlightClient> client;
+  ARROW_ASSIGN_OR_RAISE(client,
+                        arrow::flight::FlightClient::Connect(cluster.locations[0]));
+  for (int i = 0; i < 6; i++) {
+    std::string name = "airquality_" + std::to_string(i) + ".parquet";
+    ARROW_RETURN_NOT_OK(PutTable(client.get(), {}, name, *airquality));
+  }
+  rout << "Uploaded 6 datasets through member 0" << std::endl;
+  EndRecipe("ShardedParquetStorageService::DoPut");
+
+  StartRecipe("ShardedParquetStorageService::ListFlights");
+  // Any member can list every dataset in the cluster
+  std::unique_ptr<arrow::flight::FlightClient> other_client;
+  ARROW_ASSIGN_OR_RAISE(other_client,
+                        arrow::flight::FlightClient::Connect(cluster.locations[2]));
+  std::unique_ptr<arrow::flight::FlightListing> listing;
+  ARROW_ASSIGN_OR_RAISE(listing, other_client->ListFlights());
+  std::map<std::string, std::vector<int>> owners_by_name;
+  while (true) {
+    std::unique_ptr<arrow::flight::FlightInfo> flight_info;
+    ARROW_ASSIGN_OR_RAISE(flight_info, listing->Next());
+    if (!flight_info) break;
+    std::vector<int>& owners = owners_by_name[flight_info->descriptor().path[0]];
+    for (const arrow::flight::Location& location :
+         flight_info->endpoints()[0].locations) {
+      owners.push_back(cluster.MemberAt(location));
+    }
+  }
+  for (const std::pair<const std::string, std::vector<int>>& entry : owners_by_name) {
+    rout << entry.first << " is stored on members " << entry.second[0] << " and "
+         << entry.second[1] << std::endl;
+  }
+  EndRecipe("ShardedParquetStorageService::ListFlights");
+  EXPECT_EQ(owners_by_name.size(), 6);
+
+  StartRecipe("ShardedParquetStorageService::DoGet");
+  // Ask any member where a dataset is, then fetch it from the first location
+  std::vector<std::unique_ptr<arrow::flight::FlightInfo>> infos;
+  for (int i = 0; i < 6; i++) {
+    std::string name = "airquality_" + std::to_string(i) + ".parquet";
+    ARROW_ASSIGN_OR_RAISE(
+        std::unique_ptr<arrow::flight::FlightInfo> info,
+        other_client->GetFlightInfo(arrow::flight::FlightDescriptor::Path({name})));
+    infos.push_back(std::move(info));
+  }
+  ARROW_ASSIGN_OR_RAISE(int64_t rows, FetchDatasets(infos, /*rounds=*/1));
+  rout << "Read " << rows << " rows from " << infos.size() << " datasets" << std::endl;
+  EndRecipe("ShardedParquetStorageService::DoGet");
+  EXPECT_EQ(rows, 6 * airquality->num_rows());
+
+  // Every dataset is on exactly the members the listing named, and dropping it
+  // removes every copy
+  std::shared_ptr<arrow::fs::FileSystem> fs =
+      std::make_shared<arrow::fs::LocalFileSystem>();
+  for (const std::pair<const std::string, std::vector<int>>& entry : owners_by_name) {
+    for (int member = 0; member < 3; member++) {
+      std::string path =
+          "./flight_cluster/member_" + std::to_string(member) + "/" + entry.first;
+      ARROW_ASSIGN_OR_RAISE(arrow::fs::FileInfo file_info, fs->GetFileInfo(path));
+      bool is_owner = std::find(entry.second.begin(), entry.second.end(), member) !=
+                      entry.second.end();
+      EXPECT_EQ(file_info.IsFile(), is_owner) << path;
+    }
+    arrow::flight::Action action{"drop_dataset", arrow::Buffer::FromString(entry.first)};
+    ARROW_ASSIGN_OR_RAISE(std::unique_ptr<arrow::flight::ResultStream> results,
+                          client->DoAction(action));
+    ARROW_RETURN_NOT_OK(results->Drain());
+  }
+  ARROW_ASSIGN_OR_RAISE(listing, other_client->ListFlights());
+  ARROW_ASSIGN_OR_RAISE(std::unique_ptr<arrow::flight::FlightInfo> remaining,
+                        listing->Next());
+  EXPECT_EQ(remaining, nullptr);
+
+  ARROW_RETURN_NOT_OK(client->Close());
+  ARROW_RETURN_NOT_OK(other_client->Close());
+  return cluster.Shutdown();
+}
+
+/// \brief The number of files stored by all members of a cluster
+arrow::Result<size_t> CountClusterFiles(const std::string& base_dir) {
+  arrow::fs::LocalFileSystem fs;
+  arrow::fs::FileSelector selector;
+  selector.base_dir = base_dir;
+  selector.recursive = true;
+  ARROW_ASSIGN_OR_RAISE(std::vector<arrow::fs::FileInfo> listing,
+                        fs.GetFileInfo(selector));
+  return static_cast<size_t>(
+      std::count_if(listing.begin(), listing.end(),
+                    [](const arrow::fs::FileInfo& info) { return info.IsFile(); }));
+}
+
+arrow::Status TestShardedPutFailure() {
+  const std::string base_dir = "./flight_cluster_failure";
+  ARROW_ASSIGN_OR_RAISE(LocalCluster cluster,
+                        StartLocalCluster(base_dir, /*num_members=*/3,
+                                          /*num_replicas=*/1));
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Table> airquality, ReadAirQuality());
+  std::unique_ptr<arrow::flight::FlightClient> client;
+  ARROW_ASSIGN_OR_RAISE(client,
+                        arrow::flight::FlightClient::Connect(cluster.locations[0]));
+
+  // Abandon each upload halfway through, whichever members own it
+  arrow::flight::FlightDescriptor descriptor;
+  for (int i = 0; i < 3; i++) {
+    std::string name = "airquality_" + std::to_string(i) + ".parquet";
+    descriptor = arrow::flight::FlightDescriptor::Path({name});
+    ARROW_ASSIGN_OR_RAISE(arrow::flight::FlightClient::DoPutResult put,
+                          client->DoPut(descriptor, airquality->schema()));
+    ARROW_RETURN_NOT_OK(put.writer->WriteTable(*airquality->Slice(0, 10)));
+    ARROW_RETURN_NOT_OK(put.writer->WriteMetadata(arrow::Buffer::FromString(
+        ShardedParquetStorageService::kAbortUpload)));
+    EXPECT_RAISES_WITH_MESSAGE_THAT(Cancelled, testing::HasSubstr("aborted"),
+                                    put.writer->Close());
+  }
+
+  // Member 0 only answers once the other owners have discarded their copies too
+  ARROW_ASSIGN_OR_RAISE(size_t num_files, CountClusterFiles(base_dir));
+  EXPECT_EQ(num_files, 0);
+
+  // The members still accept the same upload afterwards
+  ARROW_RETURN_NOT_OK(PutTable(client.get(), {}, descriptor.path[0], *airquality));
+  ARROW_ASSIGN_OR_RAISE(std::unique_ptr<arrow::flight::FlightInfo> info,
+                        client->GetFlightInfo(descriptor));
+  EXPECT_EQ(info->total_records(), airquality->num_rows());
+  ARROW_ASSIGN_OR_RAISE(num_files, CountClusterFiles(base_dir));
+  EXPECT_EQ(num_files, 2);
+
+  ARROW_RETURN_NOT_OK(client->Close());
+  return cluster.Shutdown();
+}
+
 TEST(ParquetStorageServiceTest, PutGetDelete) { ASSERT_OK(TestPutGetDelete()); }
 TEST(ParquetStorageServiceTest, TestClientOptions) {
   auto status = TestClientOptions();
@@ -409,3 +992,18 @@ TEST(ParquetStorageServiceTest, TestClientOptions) {
   ASSERT_THAT(status.message(), testing::HasSubstr("resource exhausted"));
 }
 TEST(ParquetStorageServiceTest, TestCustomGrpcImpl) { ASSERT_OK(TestCustomGrpcImpl()); }
+TEST(ParquetStorageServiceTest, ShardedStorage) { ASSERT_OK(TestShardedStorage()); }
+TEST(ParquetStorageServiceTest, ShardedPutFailure) { ASSERT_OK(TestShardedPutFailure()); }
+TEST(ParquetStorageServiceTest, ClusterMembersValidation) {
+  ASSERT_RAISES(Invalid, StartLocalCluster("./flight_cluster", /*num_members=*/0,
+                                           /*num_replicas=*/0));
+  ASSERT_RAISES(Invalid, StartLocalCluster("./flight_cluster", /*num_members=*/1,
+                                           /*num_replicas=*/-1));
+
+  ShardedParquetStorageService service(std::make_shared<arrow::fs::LocalFileSystem>());
+  ASSERT_RAISES(Invalid, service.SetMembers({}, 0));
+  ASSERT_OK_AND_ASSIGN(arrow::flight::Location location,
+                       arrow::flight::Location::ForGrpcTcp("localhost", 12345));
+  ASSERT_RAISES(Invalid, service.SetMembers({location}, 1));
+  ASSERT_OK(service.SetMembers({location}, 0));
+}
@@ -0,0 +1,76 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef ARROW_COOKBOOK_FLIGHT_H
+#define ARROW_COOKBOOK_FLIGHT_H
+
+// Code from flight.cc that flight_benchmark.cc measures
+
+#include <arrow/api.h>
+#include <arrow/flight/client.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+class ShardedParquetStorageService;
+
+/// \brief Several ShardedParquetStorageService members running in this process
+///
+/// The members are shut down when the cluster is destroyed.  Call Shutdown before
+/// that to find out whether it worked.
+struct LocalCluster {
+  LocalCluster();
+  LocalCluster(LocalCluster&&);
+  LocalCluster& operator=(LocalCluster&&) = delete;
+  ~LocalCluster();
+
+  /// \brief The index of the member at `location`, or -1
+  int MemberAt(const arrow::flight::Location& location) const;
+
+  /// \brief Shut down every member that is still running
+  arrow::Status Shutdown();
+
+  std::vector<std::unique_ptr<ShardedParquetStorageService>> members;
+  std::vector<arrow::flight::Location> locations;
+};
+
+/// \brief Start a cluster on localhost, each member storing datasets in its own
+/// directory under `base_dir`
+arrow::Result<LocalCluster> StartLocalCluster(const std::string& base_dir,
+                                              size_t num_members, int num_replicas);
+
+/// \brief Upload a table to a Flight service under the given name
+arrow::Status PutTable(arrow::flight::FlightClient* client,
+                       const arrow::flight::FlightCallOptions& options,
+                       const std::string& name, const arrow::Table& table);
+
+/// \brief Fetch every dataset from the members its endpoints point at, `rounds`
+/// times over, and return the total number of rows read
+///
+/// Each round starts at `infos[first]` and wraps around, so clients given different
+/// starting points spread their requests over the members.
+arrow::Result<int64_t> FetchDatasets(
+    const std::vector<std::unique_ptr<arrow::flight::FlightInfo>>& infos, int rounds,
+    size_t first = 0);
+
+/// \brief Read the airquality test data
+arrow::Result<std::shared_ptr<arrow::Table>> ReadAirQuality();
+
+#endif  // ARROW_COOKBOOK_FLIGHT_H
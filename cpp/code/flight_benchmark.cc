@@ -0,0 +1,101 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <benchmark/benchmark.h>
+
+#include <arrow/api.h>
+#include <arrow/flight/client.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "benchmark_common.h"
+#include "flight.h"
+
+// Benchmarks for the recipes in flight.cc
+
+namespace {
+
+/// \brief Several clients fetching every dataset at once from a cluster of
+/// `num_members` members.  Each client starts at a different dataset, so at any
+/// moment the clients are spread over the members, and more members should serve
+/// more rows per second.
+arrow::Status FetchFromCluster(benchmark::State& state, size_t num_members) {
+  constexpr int kNumDatasets = 16;
+  constexpr int kNumClients = 8;
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Table> airquality, ReadAirQuality());
+  std::vector<std::shared_ptr<arrow::Table>> copies(50, airquality);
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Table> dataset,
+                        arrow::ConcatenateTables(copies));
+  ARROW_ASSIGN_OR_RAISE(LocalCluster cluster,
+                        StartLocalCluster("./flight_cluster_benchmark", num_members,
+                                          /*num_replicas=*/0));
+  std::unique_ptr<arrow::flight::FlightClient> client;
+  ARROW_ASSIGN_OR_RAISE(client,
+                        arrow::flight::FlightClient::Connect(cluster.locations[0]));
+  std::vector<std::unique_ptr<arrow::flight::FlightInfo>> infos;
+  for (int i = 0; i < kNumDatasets; i++) {
+    std::string name = "dataset_" + std::to_string(i) + ".parquet";
+    ARROW_RETURN_NOT_OK(PutTable(client.get(), {}, name, *dataset));
+    ARROW_ASSIGN_OR_RAISE(
+        std::unique_ptr<arrow::flight::FlightInfo> info,
+        client->GetFlightInfo(arrow::flight::FlightDescriptor::Path({name})));
+    infos.push_back(std::move(info));
+  }
+
+  int64_t rows = 0;
+  for (auto _ : state) {
+    std::vector<arrow::Result<int64_t>> results(kNumClients, int64_t{0});
+    std::vector<std::thread> threads;
+    for (int i = 0; i < kNumClients; i++) {
+      size_t first = static_cast<size_t>(i) * infos.size() / kNumClients;
+      threads.emplace_back(
+          [&, i, first] { results[i] = FetchDatasets(infos, /*rounds=*/1, first); });
+    }
+    for (std::thread& thread : threads) {
+      thread.join();
+    }
+    for (const arrow::Result<int64_t>& result : results) {
+      ARROW_RETURN_NOT_OK(result.status());
+      rows += *result;
+    }
+  }
+  state.SetItemsProcessed(rows);
+  state.counters["rows_per_second"] =
+      benchmark::Counter(static_cast<double>(rows), benchmark::Counter::kIsRate);
+  ARROW_RETURN_NOT_OK(client->Close());
+  return cluster.Shutdown();
+}
+
+int RegisterClusterBenchmarks() {
+  for (size_t num_members : {1, 2, 4}) {
+    RegisterArrowBenchmark("FetchFromCluster/members:" + std::to_string(num_members),
+                           FetchFromCluster, num_members)
+        ->UseRealTime()
+        ->Unit(benchmark::kMillisecond);
+  }
+  return 0;
+}
+
+[[maybe_unused]] const int kClusterBenchmarksRegistered = RegisterClusterBenchmarks();
+
+}  // namespace
@@ -15,6 +15,7 @@
 // specific language governing permissions and limitations
 // under the License.
 
+#include <cstdlib>
 #include <iostream>
 
 #include <filesystem>
@@ -33,7 +34,12 @@ int main(int argc, char** argv) {
   testing::InitGoogleTest(&argc, argv);
   int retval = RUN_ALL_TESTS();
   if (retval == 0 && HasRecipeOutput()) {
-    arrow::Status st = DumpRecipeOutput("recipes_out.arrow");
+    // Set RECIPE_BASELINE to a recipes_out.arrow from an earlier run to report
+    // recipes that got slower or allocate more than they used to
+    const char* baseline = std::getenv("RECIPE_BASELINE");
+    const char* threshold = std::getenv("RECIPE_REGRESSION_THRESHOLD");
+    arrow::Status st = DumpRecipeOutput("recipes_out.arrow", baseline ? baseline : "",
+                                        threshold ? std::atof(threshold) : 0.25);
     if (!st.ok()) {
       std::cerr << "Tests ran successfully but failed to dump recipe output: " << st
                 << std::endl;